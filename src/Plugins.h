@@ -34,6 +34,7 @@ public:
     void Cleanup();
 
     bool hasPlugins();
+    bool hasChannelDataPlugins() const { return !mChannelDataPlugins.empty(); }
 
     void mediaCallback(const Json::Value& playlist, const MediaDetails& mediaDetails);
     void playlistCallback(const Json::Value& playlist, const std::string& action, const std::string& section, int item);
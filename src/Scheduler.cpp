@@ -12,6 +12,7 @@
 
 #include "fpp-pch.h"
 
+#include <algorithm>
 #include <ctime>
 #include <list>
 #include <map>
@@ -66,6 +67,8 @@ Scheduler::Scheduler() :
     m_lastProcTime(0),
     m_timeDelta(0),
     m_timeDeltaThreshold(0),
+    m_firstUnranTime(0),
+    m_entryTimesCalculated(0),
     m_forcedNextPlaylist(SCHEDULE_INDEX_INVALID) {
     RegisterCommands();
 
@@ -81,6 +84,10 @@ Scheduler::Scheduler() :
 }
 
 Scheduler::~Scheduler() {
+    ClearScheduledItems();
+    for (auto& item : m_freeItems) {
+        delete item;
+    }
 }
 
 void Scheduler::ScheduleProc(void) {
@@ -137,7 +144,7 @@ void Scheduler::CheckIfShouldBePlayingNow(int ignoreRepeat, int forceStopped) {
         }
 
         LogExcess(VB_SCHEDULE, "Checking scheduled items:\n");
-        for (auto& item : *itemTime.second) {
+        for (auto& item : itemTime.second) {
             if (WillLog(LOG_EXCESSIVE, VB_SCHEDULE))
                 DumpScheduledItem(item->startTime, item);
             if (item->command == "Start Playlist") {
@@ -157,7 +164,7 @@ void Scheduler::CheckIfShouldBePlayingNow(int ignoreRepeat, int forceStopped) {
                     (forceStopped != item->entryIndex) &&
                     (item->entry->repeat || ir)) {
                     LogExcess(VB_SCHEDULE, "Item run status reset\n");
-                    item->ran = false;
+                    ResetItemRan(item);
                 }
             }
         }
@@ -179,7 +186,7 @@ std::string Scheduler::GetPlaylistThatShouldBePlaying(int& repeat) {
             break; // no need to look at items that are further in the future
         }
 
-        for (auto& item : *itemTime.second) {
+        for (auto& item : itemTime.second) {
             if (item->command == "Start Playlist") {
                 // Skip things that should have ended in the past
                 if (item->endTime <= now) {
@@ -200,7 +207,7 @@ void Scheduler::ReloadScheduleFile(void) {
     m_loadSchedule = true;
 }
 
-void Scheduler::AddScheduledItems(ScheduleEntry* entry, int index) {
+void Scheduler::AddScheduledItems(ScheduleEntry* entry, int index, EntryTimesMap* prevTimes) {
     if (!entry->enabled)
         return;
 
@@ -229,6 +236,173 @@ void Scheduler::AddScheduledItems(ScheduleEntry* entry, int index) {
         }
     }
 
+    std::time_t currTime = std::time(nullptr);
+
+    if (prevTimes) {
+        // Anything that changes the times an entry expands to is part of the key
+        char key[256];
+        snprintf(key, sizeof(key), "%d|%02d:%02d:%02d|%s|%d|%02d:%02d:%02d|%s|%d|%d|%d|%d",
+                 entry->dayIndex,
+                 entry->startHour, entry->startMinute, entry->startSecond,
+                 entry->startTimeStr.c_str(), entry->startTimeOffset,
+                 entry->endHour, entry->endMinute, entry->endSecond,
+                 entry->endTimeStr.c_str(), entry->endTimeOffset,
+                 entry->repeatInterval, entry->startDate, entry->endDate);
+
+        auto times = m_entryTimes.find(key);
+        if (times == m_entryTimes.end()) {
+            auto prev = prevTimes->find(key);
+            if (prev != prevTimes->end()) {
+                times = m_entryTimes.insert(prevTimes->extract(prev)).position;
+            } else {
+                CalculateStartEndTimes(entry);
+                times = m_entryTimes.emplace(key, entry->startEndTimes).first;
+                m_entryTimesCalculated++;
+            }
+        }
+        entry->startEndTimes = times->second;
+    } else {
+        CalculateStartEndTimes(entry);
+        m_entryTimesCalculated++;
+    }
+
+    // loop through entry->startEndTimes and add to m_scheduledItems
+    time_t startTime = 0;
+    time_t endTime = 0;
+    for (auto& startEnd : entry->startEndTimes) {
+        startTime = startEnd.first;
+        endTime = startEnd.second;
+
+        // Times may have been calculated earlier today
+        if (endTime < currTime)
+            continue;
+
+        // Check to see if this occurrence is within the date range
+        struct tm later;
+        localtime_r(&startTime, &later);
+        int dateInt = 0;
+        dateInt += (later.tm_year + 1900) * 10000;
+        dateInt += (later.tm_mon + 1) * 100;
+        dateInt += (later.tm_mday);
+
+        // Skip if occurrence is outside the date range
+        if (!DateInRange(dateInt, entry->startDate, entry->endDate)) {
+            continue;
+        }
+
+        ScheduledItem* newItem = NewScheduledItem();
+
+        newItem->entry = entry;
+        newItem->entryIndex = index;
+        newItem->priority = index; // change this if we add a priority field
+        newItem->startTime = startTime;
+        newItem->endTime = startTime;
+
+        if (entry->playlist != "") {
+            // Old style schedule entry without a FPP Command
+            Json::Value args(Json::arrayValue);
+            args.append(entry->playlist);
+            args.append(entry->repeat ? "true" : "false");
+            args.append("false");
+
+            newItem->command = "Start Playlist";
+            newItem->args = args;
+            newItem->endTime = endTime;
+
+            // Check to see if this item already ran
+            auto sVec = m_ranItems.find(newItem->startTime);
+            if (sVec != m_ranItems.end()) {
+                for (auto& item : sVec->second) {
+                    if ((newItem->command == item.command) &&
+                        (newItem->startTime == item.startTime) &&
+                        (newItem->endTime == item.endTime) &&
+                        (newItem->args.size() == item.args.size()) &&
+                        ((!newItem->args.size() && !item.args.size()) ||
+                         (newItem->args[0].asString() == item.args[0].asString()))) {
+                        LogDebug(VB_SCHEDULE, "Marking playlist item as already ran:\n");
+                        DumpScheduledItem(newItem->startTime, newItem);
+                        newItem->ran = true;
+                    }
+                }
+            }
+        } else {
+            // New style schedule entry with a FPP Command
+            newItem->command = entry->command;
+            newItem->args = entry->args;
+        }
+
+        m_newItems.push_back(newItem);
+    }
+}
+
+ScheduledItem* Scheduler::NewScheduledItem() {
+    if (m_freeItems.empty())
+        return new ScheduledItem;
+
+    ScheduledItem* item = m_freeItems.back();
+    m_freeItems.pop_back();
+
+    // command and args are always overwritten by the caller
+    item->priority = 1;
+    item->entry = nullptr;
+    item->ran = false;
+
+    return item;
+}
+
+void Scheduler::IndexScheduledItems() {
+    // Sorting first means every item goes on the end of the map instead of
+    // searching for its spot, stable to keep items at the same time in
+    // priority order.
+    std::stable_sort(m_newItems.begin(), m_newItems.end(),
+                     [](const ScheduledItem* a, const ScheduledItem* b) {
+                         return a->startTime < b->startTime;
+                     });
+
+    for (auto& item : m_newItems) {
+        if (!m_scheduledItems.empty() && (m_scheduledItems.rbegin()->first == item->startTime)) {
+            m_scheduledItems.rbegin()->second.push_back(item);
+        } else if (!m_freeNodes.empty()) {
+            auto node = std::move(m_freeNodes.back());
+            m_freeNodes.pop_back();
+            node.key() = item->startTime;
+            node.mapped().push_back(item);
+            m_scheduledItems.insert(m_scheduledItems.end(), std::move(node));
+        } else {
+            m_scheduledItems.emplace_hint(m_scheduledItems.end(), item->startTime,
+                                          std::vector<ScheduledItem*>(1, item));
+        }
+    }
+    m_newItems.clear();
+}
+
+Scheduler::ScheduledItemMap::iterator Scheduler::FirstUnranItems() {
+    auto it = m_scheduledItems.lower_bound(m_firstUnranTime);
+    while (it != m_scheduledItems.end()) {
+        bool allRan = true;
+        for (auto& item : it->second) {
+            if (!item->ran) {
+                allRan = false;
+                break;
+            }
+        }
+
+        if (!allRan)
+            break;
+
+        ++it;
+    }
+
+    if (it != m_scheduledItems.end())
+        m_firstUnranTime = it->first;
+    else if (!m_scheduledItems.empty())
+        m_firstUnranTime = m_scheduledItems.rbegin()->first + 1;
+
+    return it;
+}
+
+
+void Scheduler::CalculateStartEndTimes(ScheduleEntry* entry) {
     int dayIndex = entry->dayIndex;
     std::time_t currTime = std::time(nullptr);
     struct tm now;
@@ -336,76 +510,6 @@ void Scheduler::AddScheduledItems(ScheduleEntry* entry, int index) {
         }
     }
 
-    // loop through entry->startEndTimes and add to m_scheduledItems
-    time_t startTime = 0;
-    time_t endTime = 0;
-    for (auto& startEnd : entry->startEndTimes) {
-        startTime = startEnd.first;
-        endTime = startEnd.second;
-
-        // Check to see if this occurrence is within the date range
-        struct tm later;
-        localtime_r(&startTime, &later);
-        int dateInt = 0;
-        dateInt += (later.tm_year + 1900) * 10000;
-        dateInt += (later.tm_mon + 1) * 100;
-        dateInt += (later.tm_mday);
-
-        // Skip if occurrence is outside the date range
-        if (!DateInRange(dateInt, entry->startDate, entry->endDate)) {
-            continue;
-        }
-
-        ScheduledItem* newItem = new ScheduledItem;
-
-        newItem->entry = entry;
-        newItem->entryIndex = index;
-        newItem->priority = index; // change this if we add a priority field
-        newItem->startTime = startTime;
-        newItem->endTime = startTime;
-
-        if (entry->playlist != "") {
-            // Old style schedule entry without a FPP Command
-            Json::Value args(Json::arrayValue);
-            args.append(entry->playlist);
-            args.append(entry->repeat ? "true" : "false");
-            args.append("false");
-
-            newItem->command = "Start Playlist";
-            newItem->args = args;
-            newItem->endTime = endTime;
-
-            // Check to see if this item already ran
-            auto sVec = m_ranItems.find(newItem->startTime);
-            if (sVec != m_ranItems.end()) {
-                for (auto& item : *sVec->second) {
-                    if ((newItem->command == item->command) &&
-                        (newItem->startTime == item->startTime) &&
-                        (newItem->endTime == item->endTime) &&
-                        (newItem->args.size() == item->args.size()) &&
-                        ((!newItem->args.size() && !item->args.size()) ||
-                         (newItem->args[0].asString() == item->args[0].asString()))) {
-                        LogDebug(VB_SCHEDULE, "Marking playlist item as already ran:\n");
-                        DumpScheduledItem(newItem->startTime, newItem);
-                        newItem->ran = true;
-                    }
-                }
-            }
-        } else {
-            // New style schedule entry with a FPP Command
-            newItem->command = entry->command;
-            newItem->args = entry->args;
-        }
-
-        auto sVec = m_scheduledItems.find(startTime);
-        if (sVec != m_scheduledItems.end()) {
-            sVec->second->push_back(newItem);
-        } else {
-            std::vector<ScheduledItem*>* newVec = new std::vector<ScheduledItem*>;
-            newVec->push_back(newItem);
-            m_scheduledItems[startTime] = newVec;
-        }
-    }
 }
 
 void Scheduler::DumpScheduledItem(std::time_t itemTime, ScheduledItem* item) {
@@ -429,13 +533,13 @@ void Scheduler::DumpScheduledItems() {
     LogDebug(VB_SCHEDULE, "DumpScheduledItems()\n");
 
     for (const auto& itemTime : m_scheduledItems) {
-        for (const auto& item : *itemTime.second) {
+        for (const auto& item : itemTime.second) {
             DumpScheduledItem(itemTime.first, item);
         }
     }
 }
 
-void Scheduler::doCountdown(const std::time_t& now, const std::time_t& itemTime, std::vector<ScheduledItem*>* items) {
+void Scheduler::doCountdown(const std::time_t& now, const std::time_t& itemTime, std::vector<ScheduledItem*>& items) {
     // Check to see if we should be counting down to the next item
     bool logItems = false;
     int diff = itemTime - now;
@@ -450,11 +554,11 @@ void Scheduler::doCountdown(const std::time_t& now, const std::time_t& itemTime,
 
     if (logItems) {
         LogDebug(VB_SCHEDULE, "Scheduled Item%s running in %d second%s:\n",
-                 items->size() == 1 ? "" : "s",
+                 items.size() == 1 ? "" : "s",
                  diff,
                  diff == 1 ? "" : "s");
 
-        for (auto& item : *items) {
+        for (auto& item : items) {
             if ((item->command == "Start Playlist") &&
                 (diff < 1000)) {
                 char tmpStr[27];
@@ -531,12 +635,12 @@ bool Scheduler::doScheduledPlaylist(const std::time_t& now, const std::time_t& i
             // running playlist to false so it shows as 'next' again
             std::time_t oldStartTime = Player::INSTANCE.GetOrigStartTime();
             std::string playlistName = Player::INSTANCE.GetPlaylistName();
-            std::vector<ScheduledItem*>* oldItems = m_scheduledItems[oldStartTime];
-            if (oldItems) {
-                for (auto& oldItem : *oldItems) {
+            auto oldItems = m_scheduledItems.find(oldStartTime);
+            if (oldItems != m_scheduledItems.end()) {
+                for (auto& oldItem : oldItems->second) {
                     if ((oldItem->command == "Start Playlist") &&
                         (oldItem->entry->playlist == playlistName)) {
-                        oldItem->ran = false;
+                        ResetItemRan(oldItem);
                         m_forcedNextPlaylist = oldItem->entryIndex;
                     }
                 }
@@ -593,15 +697,17 @@ void Scheduler::CheckScheduledItems(bool restarted) {
     if (m_schedulerDisabled)
         return;
 
+    std::unique_lock<std::recursive_mutex> lock(m_scheduleLock);
     std::time_t now = time(nullptr);
 
-    for (auto& itemTime : m_scheduledItems) {
+    for (auto it = FirstUnranItems(); it != m_scheduledItems.end(); ++it) {
+        auto& itemTime = *it;
         if (itemTime.first > now) {
             doCountdown(now, itemTime.first, itemTime.second);
             break; // no need to look at items that are further in the future
         }
 
-        for (auto& item : *itemTime.second) {
+        for (auto& item : itemTime.second) {
             if (item->ran)
                 continue; // skip over any items that ran already
 
@@ -623,46 +729,51 @@ void Scheduler::CheckScheduledItems(bool restarted) {
 }
 
 void Scheduler::ClearScheduledItems() {
-    for (auto& itemTime : m_scheduledItems) {
-        for (auto& item : *itemTime.second) {
-            delete item;
-        }
-        delete itemTime.second;
+    while (!m_scheduledItems.empty()) {
+        auto node = m_scheduledItems.extract(m_scheduledItems.begin());
+        m_freeItems.insert(m_freeItems.end(), node.mapped().begin(), node.mapped().end());
+        node.mapped().clear();
+        m_freeNodes.push_back(std::move(node));
     }
-    m_scheduledItems.clear();
+    m_firstUnranTime = 0;
+}
+
+void Scheduler::ResetItemRan(ScheduledItem* item) {
+    item->ran = false;
+    if (item->startTime < m_firstUnranTime)
+        m_firstUnranTime = item->startTime;
 }
 
 void Scheduler::SetItemRan(ScheduledItem* item, bool ran) {
-    item->ran = ran;
-
-    auto sVec = m_ranItems.find(item->startTime);
-    if (sVec != m_ranItems.end()) {
-        bool found = false;
-        for (auto& ranItem : *sVec->second) {
-            if ((item->command == ranItem->command) &&
-                (item->startTime == ranItem->startTime) &&
-                (item->endTime == ranItem->endTime) &&
-                (item->args.size() == ranItem->args.size()) &&
-                ((!item->args.size() && !ranItem->args.size()) ||
-                 (item->args[0].asString() == ranItem->args[0].asString()))) {
-                ranItem->ran = ran;
-                found = true;
-            }
+    if (ran)
+        item->ran = true;
+    else
+        ResetItemRan(item);
+
+    std::vector<ScheduledItem>& ranItems = m_ranItems[item->startTime];
+    bool found = false;
+    for (auto& ranItem : ranItems) {
+        if ((item->command == ranItem.command) &&
+            (item->startTime == ranItem.startTime) &&
+            (item->endTime == ranItem.endTime) &&
+            (item->args.size() == ranItem.args.size()) &&
+            ((!item->args.size() && !ranItem.args.size()) ||
+             (item->args[0].asString() == ranItem.args[0].asString()))) {
+            ranItem.ran = ran;
+            found = true;
         }
-
-        if (!found)
-            sVec->second->push_back(new ScheduledItem(item));
-    } else {
-        std::vector<ScheduledItem*>* newVec = new std::vector<ScheduledItem*>;
-        newVec->push_back(new ScheduledItem(item));
-        m_ranItems[item->startTime] = newVec;
     }
+
+    if (!found)
+        ranItems.emplace_back(item);
 }
 
 void Scheduler::LoadScheduleFromFile(void) {
     std::string SCHEDULE_FILE = FPP_DIR_CONFIG("/schedule.json");
     LogDebug(VB_SCHEDULE, "Loading Schedule from %s\n", SCHEDULE_FILE.c_str());
 
+    long long loadStart = GetTimeMS();
+
     m_loadSchedule = false;
     m_lastLoadDate = GetCurrentDateInt();
 
@@ -673,6 +784,7 @@ void Scheduler::LoadScheduleFromFile(void) {
     std::string playlistFile;
 
     Json::Value sch = LoadJsonFromFile(SCHEDULE_FILE);
+    m_Schedule.reserve(sch.size());
     for (int i = 0; i < sch.size(); i++) {
         ScheduleEntry scheduleEntry;
         if (!scheduleEntry.LoadFromJson(sch[i]))
@@ -718,9 +830,30 @@ void Scheduler::LoadScheduleFromFile(void) {
         m_Schedule.push_back(scheduleEntry);
     }
 
+    // Previously calculated times can't be reused while a time delta
+    // is being applied since it depends on the current time
+    std::string timesKey = std::to_string(m_lastLoadDate) + "|" +
+                           getSetting("ScheduleDistance") + "|" +
+                           getSetting("Latitude") + "|" +
+                           getSetting("Longitude") + "|" +
+                           getSetting("TimeZone");
+    if ((m_timeDelta != 0) || (timesKey != m_entryTimesKey)) {
+        m_entryTimes.clear();
+        m_entryTimesKey = timesKey;
+    }
+
+    EntryTimesMap prevTimes;
+    prevTimes.swap(m_entryTimes);
+    m_entryTimesCalculated = 0;
+
     for (int i = 0; i < m_Schedule.size(); i++) {
-        AddScheduledItems(&m_Schedule[i], i);
+        AddScheduledItems(&m_Schedule[i], i, m_timeDelta ? nullptr : &prevTimes);
     }
+    IndexScheduledItems();
+
+    LogDebug(VB_SCHEDULE, "Schedule loaded in %lldms, %d entries (%d recalculated), %d start times\n",
+             GetTimeMS() - loadStart, (int)m_Schedule.size(), m_entryTimesCalculated,
+             (int)m_scheduledItems.size());
 
     SchedulePrint();
 
@@ -770,8 +903,8 @@ ScheduledItem* Scheduler::GetNextScheduledPlaylist() {
     std::time_t now = time(nullptr);
     std::unique_lock<std::recursive_mutex> lock(m_scheduleLock);
 
-    for (auto& itemTime : m_scheduledItems) {
-        for (auto& item : *itemTime.second) {
+    for (auto it = FirstUnranItems(); it != m_scheduledItems.end(); ++it) {
+        for (auto& item : it->second) {
             if (item->ran)
                 continue; // skip over any items that ran already
 
@@ -783,6 +916,19 @@ ScheduledItem* Scheduler::GetNextScheduledPlaylist() {
     return nullptr;
 }
 
+int Scheduler::GetScheduledItemCount(int* times) {
+    std::unique_lock<std::recursive_mutex> lock(m_scheduleLock);
+
+    int count = 0;
+    for (auto& itemTime : m_scheduledItems)
+        count += itemTime.second.size();
+
+    if (times)
+        *times = m_scheduledItems.size();
+
+    return count;
+}
+
 std::string Scheduler::GetNextPlaylistName() {
     if (m_schedulerDisabled)
         return "Scheduler is disabled.";
@@ -1023,8 +1169,8 @@ Json::Value Scheduler::GetSchedule() {
         items.append(scheduledItem);
     }
 
-    for (auto& itemTime : m_scheduledItems) {
-        for (auto& item : *itemTime.second) {
+    for (auto it = FirstUnranItems(); it != m_scheduledItems.end(); ++it) {
+        for (auto& item : it->second) {
             if (item->ran)
                 continue;
 
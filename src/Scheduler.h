@@ -13,6 +13,8 @@
 
 #include <map>
 #include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <pthread.h>
@@ -74,6 +76,8 @@ public:
 };
 
 class Scheduler {
+    typedef std::map<std::time_t, std::vector<ScheduledItem*>> ScheduledItemMap;
+
 public:
     Scheduler();
     ~Scheduler();
@@ -91,22 +95,36 @@ public:
     Json::Value GetInfo(void);
     Json::Value GetSchedule(void);
 
+    // Rebuild, check and next lookup entry points ScheduleProc and the
+    // status calls are built from, each takes the schedule lock itself
+    void LoadScheduleFromFile(void);
+    void CheckScheduledItems(bool restarted = false);
+    ScheduledItem* GetNextScheduledPlaylist();
+    int GetScheduledItemCount(int* times = nullptr);
+
 private:
-    void AddScheduledItems(ScheduleEntry* entry, int index);
+    typedef std::map<std::string, std::vector<std::pair<time_t, time_t>>> EntryTimesMap;
+
+    void AddScheduledItems(ScheduleEntry* entry, int index, EntryTimesMap* prevTimes);
+    void CalculateStartEndTimes(ScheduleEntry* entry);
     void DumpScheduledItem(std::time_t itemTime, ScheduledItem* item);
     void DumpScheduledItems();
-    void CheckScheduledItems(bool restarted = false);
     void ClearScheduledItems();
     void SetItemRan(ScheduledItem* item, bool ran);
+    void ResetItemRan(ScheduledItem* item);
+
+    // ScheduledItems and the map nodes holding them are recycled across
+    // schedule reloads instead of being freed and reallocated
+    ScheduledItem* NewScheduledItem();
+    void IndexScheduledItems();
+    ScheduledItemMap::iterator FirstUnranItems();
 
-    ScheduledItem* GetNextScheduledPlaylist();
-    void LoadScheduleFromFile(void);
     void SchedulePrint(void);
     std::string GetDayTextFromDayIndex(const int index);
 
     void RegisterCommands();
 
-    void doCountdown(const std::time_t& now, const std::time_t& itemTime, std::vector<ScheduledItem*>* items);
+    void doCountdown(const std::time_t& now, const std::time_t& itemTime, std::vector<ScheduledItem*>& items);
     void doScheduledCommand(const std::time_t& itemTime, ScheduledItem* item);
     bool doScheduledPlaylist(const std::time_t& now, const std::time_t& itemTime, ScheduledItem* item, bool restarted);
 
@@ -120,9 +138,25 @@ private:
 
     std::recursive_mutex m_scheduleLock;
     std::vector<ScheduleEntry> m_Schedule;
-    std::map<std::time_t, std::vector<ScheduledItem*>*> m_scheduledItems;
-    std::map<std::time_t, std::vector<ScheduledItem*>*> m_oldItems;
-    std::map<std::time_t, std::vector<ScheduledItem*>*> m_ranItems;
+    ScheduledItemMap m_scheduledItems;
+    std::map<std::time_t, std::vector<ScheduledItem>> m_ranItems;
+
+    std::vector<ScheduledItem*> m_freeItems;
+    std::vector<ScheduledItemMap::node_type> m_freeNodes;
+    std::vector<ScheduledItem*> m_newItems; // added but not yet indexed
+
+    // Everything in m_scheduledItems before this time has already run,
+    // it only moves backwards when an item's ran flag is reset.
+    std::time_t m_firstUnranTime;
+
+    // The start/end times an entry expands to only depend on its day and
+    // time fields and the current date (plus lat/lon for sun based times),
+    // so they are kept across reloads and only entries that changed are
+    // expanded again.  Cleared when the date or settings they depend on
+    // change or an Extend Schedule delta is active.
+    EntryTimesMap m_entryTimes;
+    std::string m_entryTimesKey;
+    int m_entryTimesCalculated;
 
     int m_forcedNextPlaylist;
 };
@@ -16,12 +16,14 @@
 #include <asm-generic/hugetlb_encode.h>
 #endif
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cinttypes>
 #include <cstdint>
-#include <list>
+#include <deque>
 #include <map>
 #include <mutex>
 #include <stdio.h>
@@ -35,6 +37,7 @@
 #include "MultiSync.h"
 #include "Player.h"
 #include "Plugins.h"
+#include "SequenceReencoder.h"
 #include "Warnings.h"
 #include "common.h"
 #include "effects.h"
@@ -47,6 +50,7 @@
 #include "mediaoutput/SDLOut.h"
 #include "overlays/PixelOverlay.h"
 #include "playlist/Playlist.h"
+#include "util/DirtyRanges.h"
 
 #include "Sequence.h"
 
@@ -57,6 +61,57 @@ using namespace std::literals::chrono_literals;
 #include "mediaoutput/SDLOut.h"
 
 #define SEQUENCE_CACHE_FRAMECOUNT 40
+#define SEQUENCE_PAST_FRAMECOUNT 20
+// enough to hold a full cache of read ahead frames and past frames plus the ones in flight
+#define SEQUENCE_POOL_FRAMECOUNT (SEQUENCE_CACHE_FRAMECOUNT + SEQUENCE_PAST_FRAMECOUNT + 4)
+// frames read by PreloadSequenceFile, enough for the reader to catch up
+#define SEQUENCE_PRELOAD_FRAMECOUNT 10
+// anything longer between sequences is a pause, not a transition
+#define SEQUENCE_MAX_TRANSITION_GAP_US (5 * 1000 * 1000)
+
+class Sequence::CachedSequence {
+public:
+    std::string version; // mtime and size of the file when it was cached
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    uint32_t frameSize = 0;
+    uint32_t numFrames = 0;
+    std::unique_ptr<uint8_t[]> data;
+
+    // only touched by the thread recording it
+    std::vector<bool> recorded;
+    uint32_t recordedCount = 0;
+
+    // under m_seqCacheLock
+    bool complete = false;
+    bool inUse = false;
+    uint64_t lastUsed = 0;
+
+    uint64_t size() const { return (uint64_t)frameSize * numFrames; }
+    uint8_t* frameData(uint32_t frame) const { return &data[(uint64_t)frame * frameSize]; }
+};
+
+class Sequence::CachedFrameData : public FSEQFile::FrameData {
+public:
+    CachedFrameData(uint32_t frame, const std::shared_ptr<CachedSequence>& s) :
+        FrameData(frame),
+        seq(s) {}
+
+    virtual bool readFrame(uint8_t* data, uint32_t maxChannels) override {
+        if (!seq) {
+            return false;
+        }
+        const uint8_t* src = seq->frameData(frame);
+        for (auto& rng : seq->ranges) {
+            if (rng.first < maxChannels) {
+                memcpy(&data[rng.first], src, std::min(rng.second, maxChannels - rng.first));
+            }
+            src += rng.second;
+        }
+        return true;
+    }
+
+    std::shared_ptr<CachedSequence> seq;
+};
 
 Sequence* sequence = NULL;
 Sequence::Sequence() :
@@ -72,9 +127,26 @@ Sequence::Sequence() :
     m_remoteBlankCount(0),
     m_readThread(nullptr),
     m_lastFrameRead(-1),
-    m_doneRead(false),
     m_shuttingDown(false),
     m_lastFrameData(nullptr),
+    m_readRing(SEQUENCE_CACHE_FRAMECOUNT),
+    m_readGeneration(1),
+    m_doneReadGeneration(0),
+    m_readStartFrame(0),
+    m_readSkipFrames(0),
+    m_waitingForFrame(false),
+    m_frameDataPool(SEQUENCE_POOL_FRAMECOUNT),
+    m_framePoolHits(0),
+    m_framePoolMisses(0),
+    m_preloadThread(nullptr),
+    m_seqCacheSize(0),
+    m_seqCacheHits(0),
+    m_seqCacheMisses(0),
+    m_seqEndTime(0),
+    m_seqPreloaded(false),
+    m_seqDataFrame(nullptr),
+    m_seqDataFrameGeneration(0),
+    m_seqDataBlankGeneration(0),
     m_dataProcessed(false),
     m_seqFilename(""),
     m_bridgeData(nullptr),
@@ -95,12 +167,19 @@ Sequence::Sequence() :
     }
 
     m_blankBetweenSequences = getSettingInt("blankBetweenSequences");
+    m_seqCacheBudget = (uint64_t)getSettingInt("sequenceCacheSize", 64) * 1024 * 1024;
     setBridgePrioritySetting(getSetting("bridgeDataPriority", "Warn If Sequence Running"));
 
     registerSettingsListener("sequence", "blankBetweenSequences",
                              [this](const std::string& value) {
                                  m_blankBetweenSequences = getSettingInt("blankBetweenSequences");
                              });
+    registerSettingsListener("sequence", "sequenceCacheSize",
+                             [this](const std::string& value) {
+                                 std::unique_lock<std::mutex> lock(m_seqCacheLock);
+                                 m_seqCacheBudget = (uint64_t)getSettingInt("sequenceCacheSize", 64) * 1024 * 1024;
+                                 EvictCachedSequences(0);
+                             });
     registerSettingsListener("sequence", "bridgeDataPriority",
                              [this](const std::string& value) {
                                  setBridgePrioritySetting(value);
@@ -109,13 +188,15 @@ Sequence::Sequence() :
 
 Sequence::~Sequence() {
     m_shuttingDown = true;
-    frameLoadSignal.notify_all();
+    ClearPreloadedSequence();
+    WakeReader();
     if (m_readThread) {
         m_readThread->join();
         delete m_readThread;
     }
     SetLastFrameData(nullptr);
     clearCaches();
+    ClearFrameDataPool();
     if (m_seqFile) {
         delete m_seqFile;
     }
@@ -136,17 +217,105 @@ void Sequence::setBridgePrioritySetting(const std::string& value) {
     }
 }
 
+// must be called with the frameCacheLock held
 void Sequence::clearCaches() {
     while (!frameCache.empty()) {
         if (frameCache.front() != m_lastFrameData)
-            delete frameCache.front();
+            ReleaseFrameData(frameCache.front());
         frameCache.pop_front();
     }
     while (!pastFrameCache.empty()) {
         if (pastFrameCache.front() != m_lastFrameData)
-            delete pastFrameCache.front();
+            ReleaseFrameData(pastFrameCache.front());
         pastFrameCache.pop_front();
     }
+    ReadFrame rf;
+    while (m_readRing.pop(rf)) {
+        ReleaseFrameData(rf.data);
+    }
+}
+
+// must be called with the frameCacheLock held, anything read ahead
+// that has not made it into the frameCache yet is dropped
+void Sequence::RestartRead(int frame) {
+    ReadFrame rf;
+    while (m_readRing.pop(rf)) {
+        ReleaseFrameData(rf.data);
+    }
+    if (frame < 0) {
+        frame = 0;
+    }
+    m_lastFrameRead = frame - 1;
+    m_readStartFrame = frame;
+    m_readSkipFrames = 0;
+    m_readGeneration++;
+    WakeReader();
+}
+
+// must be called with the frameCacheLock held, returns the front of the
+// frameCache, pulling in the next frame from the reader if needed
+FSEQFile::FrameData* Sequence::NextCachedFrame() {
+    if (!frameCache.empty()) {
+        return frameCache.front();
+    }
+    ReadFrame rf;
+    while (m_readRing.pop(rf)) {
+        if (rf.generation == m_readGeneration) {
+            frameCache.push_back(rf.data);
+            return rf.data;
+        }
+        // read before a seek, not needed anymore
+        ReleaseFrameData(rf.data);
+    }
+    return nullptr;
+}
+
+void Sequence::WakeReader() {
+    // grab the lock so the reader cannot be between checking
+    // its wait condition and starting to wait
+    std::unique_lock<std::mutex> lock(frameLoadLock);
+    lock.unlock();
+    frameLoadSignal.notify_all();
+}
+
+// must be called with the frameCacheLock held
+void Sequence::ReleaseFrameData(FSEQFile::FrameData* data) {
+    if (data == nullptr) {
+        return;
+    }
+    FSEQFile::FrameData* loaded = data;
+    m_seqDataFrame.compare_exchange_strong(loaded, nullptr);
+    if (CachedFrameData* cfd = dynamic_cast<CachedFrameData*>(data)) {
+        // don't hold onto the cached sequence from the pool
+        cfd->seq.reset();
+    }
+    if (!m_frameDataPool.push(data)) {
+        delete data;
+    }
+}
+
+// must only be called when the read thread is not running
+void Sequence::ClearFrameDataPool() {
+    FSEQFile::FrameData* fd = nullptr;
+    while (m_frameDataPool.pop(fd)) {
+        delete fd;
+    }
+}
+
+void Sequence::LoadFrameData(FSEQFile::FrameData* data) {
+    uint64_t generation = channelDataChanges.getGeneration();
+    if (data == m_seqDataFrame) {
+        for (auto& a : GetOutputRanges()) {
+            channelDataChanges.markRestored(a.first, a.second, m_seqDataFrameGeneration);
+        }
+    } else {
+        for (auto& a : GetOutputRanges()) {
+            channelDataChanges.markDirty(a.first, a.second);
+        }
+    }
+    data->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+    m_seqDataFrame = data;
+    m_seqDataFrameGeneration = generation;
 }
 
 void Sequence::SetLastFrameData(FSEQFile::FrameData* data) {
@@ -168,7 +337,7 @@ void Sequence::SetLastFrameData(FSEQFile::FrameData* data) {
         }
 
         if (!found)
-            delete m_lastFrameData;
+            ReleaseFrameData(m_lastFrameData);
     }
 
     m_lastFrameData = data;
@@ -183,67 +352,345 @@ void ReadSequenceDataThread(Sequence* sequence) {
 }
 void Sequence::ReadFramesLoop() {
     SetThreadName("FPP-ReadFrames");
-    std::unique_lock<std::mutex> lock(frameCacheLock);
-    while (true) {
-        if (m_shuttingDown) {
-            return;
+    uint32_t generation = 0;
+    uint32_t frame = 0;
+    FSEQFile::FrameData* spare = nullptr;
+    while (!m_shuttingDown) {
+        if (generation != m_readGeneration) {
+            generation = m_readGeneration;
+            frame = m_readStartFrame;
         }
-        int cacheSize = frameCache.size();
-        if (frameCache.size() < SEQUENCE_CACHE_FRAMECOUNT && m_seqStarting < 2 && m_seqFile && !m_doneRead) {
-            uint32_t frame = (m_lastFrameRead + 1);
-            if (frame < m_seqFile->getNumFrames()) {
-                lock.unlock();
-
-                long long start = GetTimeMS();
-                std::unique_lock<std::mutex> readlock(readFileLock);
-                long long lockt = GetTimeMS();
-                FSEQFile* file = m_seqFile;
-                FSEQFile::FrameData* fd = nullptr;
-                if (m_doneRead || file == nullptr) {
-                    // memset(fd->data, 0, maxChanToRead);
+        frame += m_readSkipFrames.exchange(0);
+
+        if (!m_readRing.full() && m_seqStarting < 2 && m_seqFile && m_doneReadGeneration != generation) {
+            FSEQFile::FrameData* recycle = spare;
+            spare = nullptr;
+            if (recycle == nullptr) {
+                if (m_frameDataPool.pop(recycle)) {
+                    m_framePoolHits++;
                 } else {
-                    fd = m_seqFile->getFrame(frame);
-                }
-                long long unlock = GetTimeMS();
-                readlock.unlock();
-                long long end = GetTimeMS();
-                long long total = end - start;
-                if (total > 20 || fd == nullptr) {
-                    uint32_t lfr = m_lastFrameRead;
-                    int lt = lockt - start;
-                    int ul = end - unlock;
-                    int gf = unlock - lockt;
-
-                    LogDebug(VB_SEQUENCE, "Problem reading frame %d:   %X    Time: %d ms     Last: %d     Lock: %d   GetFrame: %d   Unlock: %d\n",
-                             frame, fd, ((int)total), lfr, lt, gf, ul);
+                    recycle = nullptr;
+                    m_framePoolMisses++;
                 }
+            }
 
-                lock.lock();
-                if (fd) {
-                    if (m_lastFrameRead == (frame - 1)) {
-                        m_lastFrameRead = frame;
-                        frameCache.push_back(fd);
-
-                        lock.unlock();
-                        frameLoadedSignal.notify_all();
-                        std::this_thread::sleep_for(1ms);
-                        lock.lock();
-                    } else {
-                        // a skip is in progress, we don't need this frame anymore
-                        delete fd;
-                    }
-                }
+            uint64_t start = GetTimeMicros();
+            std::unique_lock<std::mutex> readlock(readFileLock);
+            uint64_t lockt = GetTimeMicros();
+            FSEQFile::FrameData* fd = nullptr;
+            bool done = false;
+            if (m_seqFile == nullptr || generation != m_readGeneration) {
+                spare = recycle;
+            } else if (frame >= m_seqFile->getNumFrames()) {
+                done = true;
+                spare = recycle;
+            } else if (m_playCache) {
+                fd = GetCachedFrame(frame, recycle);
             } else {
-                m_doneRead = true;
-                lock.unlock();
+                fd = m_seqFile->getFrame(frame, recycle);
+            }
+            uint64_t unlock = GetTimeMicros();
+            readlock.unlock();
+            uint64_t end = GetTimeMicros();
+
+            if (done) {
+                m_doneReadGeneration = generation;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waitingForFrame) {
+                    std::unique_lock<std::mutex> lock(frameLoadedLock);
+                }
                 frameLoadedSignal.notify_all();
-                std::this_thread::sleep_for(1ms);
-                lock.lock();
+                continue;
+            }
+            if (fd) {
+                m_readTimes.addSample(unlock - lockt);
+            }
+            int total = (end - start) / 1000;
+            if (total > 20 || (fd == nullptr && spare == nullptr)) {
+                uint32_t lfr = m_lastFrameRead;
+                int lt = (lockt - start) / 1000;
+                int ul = (end - unlock) / 1000;
+                int gf = (unlock - lockt) / 1000;
+
+                LogDebug(VB_SEQUENCE, "Problem reading frame %d:   %X    Time: %d ms     Last: %d     Lock: %d   GetFrame: %d   Unlock: %d\n",
+                         frame, fd, total, lfr, lt, gf, ul);
+            }
+            if (fd) {
+                if (generation == m_readGeneration && m_readRing.push({ fd, generation })) {
+                    m_lastFrameRead = frame;
+                    frame++;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_waitingForFrame) {
+                        // the output thread is (about to be) waiting on this frame, make
+                        // sure it is actually waiting before notifying
+                        std::unique_lock<std::mutex> lock(frameLoadedLock);
+                    }
+                    frameLoadedSignal.notify_all();
+                } else {
+                    // a seek is in progress, we don't need this frame anymore
+                    spare = fd;
+                }
             }
         } else {
-            frameLoadSignal.wait_for(lock, 25ms);
+            std::unique_lock<std::mutex> lock(frameLoadLock);
+            frameLoadSignal.wait_for(lock, 25ms, [this, generation]() {
+                return m_shuttingDown || generation != m_readGeneration || m_readSkipFrames ||
+                       (!m_readRing.full() && m_seqStarting < 2 && m_seqFile && m_doneReadGeneration != generation);
+            });
+        }
+    }
+    delete spare;
+}
+
+Sequence::PreloadedSequence::~PreloadedSequence() {
+    for (auto f : frames) {
+        delete f;
+    }
+    if (file) {
+        delete file;
+    }
+}
+
+void Sequence::PreloadSequenceFile(const std::string& filename) {
+    std::unique_lock<std::mutex> lock(m_preloadLock);
+    if (m_preload && m_preload->filename == filename) {
+        return;
+    }
+    lock.unlock();
+    ClearPreloadedSequence();
+
+    std::string fullName = FPP_DIR_SEQUENCE("/" + filename);
+    if ((getFPPmode() == REMOTE_MODE) || !FileExists(fullName)) {
+        // remotes may need a host specific or fallback file, let Open sort that out
+        return;
+    }
+    if (IsSequenceCached(fullName)) {
+        // opening it is just reading the header
+        return;
+    }
+
+    LogDebug(VB_SEQUENCE, "Preloading sequence %s\n", filename.c_str());
+    lock.lock();
+    m_preload = std::make_unique<PreloadedSequence>();
+    m_preload->filename = filename;
+    PreloadedSequence* p = m_preload.get();
+    m_preloadThread = new std::thread([this, p, fullName]() {
+        SetThreadName("FPP-SeqPreload");
+        uint64_t start = GetTimeMicros();
+        p->file = SequenceReencoder::INSTANCE.OpenSequenceFile(fullName);
+        if (p->file) {
+            PreloadFrames(p);
+        }
+        LogDebug(VB_SEQUENCE, "Preloaded %d frames of %s in %dus\n",
+                 (int)p->frames.size(), p->filename.c_str(), (int)(GetTimeMicros() - start));
+    });
+}
+
+void Sequence::PreloadFrames(PreloadedSequence* p) {
+    p->file->prepareRead(GetOutputRanges(), 0);
+    uint32_t numFrames = std::min((uint32_t)SEQUENCE_PRELOAD_FRAMECOUNT, (uint32_t)p->file->getNumFrames());
+    for (uint32_t f = 0; f < numFrames && !p->cancel; f++) {
+        FSEQFile::FrameData* fd = p->file->getFrame(f);
+        if (fd == nullptr) {
+            break;
+        }
+        p->frames.push_back(fd);
+    }
+}
+
+// Hands over the preloaded file and frames if they are for filename,
+// anything else that was preloaded is no longer needed and is dropped
+FSEQFile* Sequence::TakePreloadedSequence(const std::string& filename, std::vector<FSEQFile::FrameData*>& frames) {
+    std::unique_lock<std::mutex> lock(m_preloadLock);
+    if (m_preloadThread) {
+        if (m_preload->filename != filename) {
+            m_preload->cancel = true;
+        }
+        m_preloadThread->join();
+        delete m_preloadThread;
+        m_preloadThread = nullptr;
+    }
+    FSEQFile* file = nullptr;
+    if (m_preload && m_preload->filename == filename && m_preload->file) {
+        file = m_preload->file;
+        m_preload->file = nullptr;
+        frames.swap(m_preload->frames);
+    }
+    m_preload.reset();
+    return file;
+}
+
+void Sequence::ClearPreloadedSequence() {
+    std::vector<FSEQFile::FrameData*> frames;
+    TakePreloadedSequence("", frames);
+}
+
+static std::string GetCacheVersion(const std::string& filename) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return "";
+    }
+    return std::to_string(st.st_mtime) + ":" + std::to_string(st.st_size);
+}
+
+// The output channels every frame of the file fills in, this is all that
+// needs to be kept.  Channels the file doesn't have are left alone when
+// playing it so they must not be cached either.
+static std::vector<std::pair<uint32_t, uint32_t>> GetCacheRanges(FSEQFile* file) {
+    std::vector<std::pair<uint32_t, uint32_t>> limits;
+    V2FSEQFile* v2 = dynamic_cast<V2FSEQFile*>(file);
+    if (v2 && !v2->m_sparseRanges.empty()) {
+        limits = v2->m_sparseRanges;
+    } else {
+        limits.emplace_back(0, file->getChannelCount());
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (auto& out : GetOutputRanges()) {
+        for (auto& lim : limits) {
+            uint32_t start = std::max(out.first, lim.first);
+            uint32_t end = std::min(out.first + out.second, lim.first + lim.second);
+            if (start < end) {
+                ranges.emplace_back(start, end - start);
+            }
+        }
+    }
+    return ranges;
+}
+
+// Returns the cache entry to play file from (if complete) or record it
+// into, nullptr if it can't be cached
+std::shared_ptr<Sequence::CachedSequence> Sequence::GetCachedSequence(const std::string& filename, FSEQFile* file) {
+    std::unique_lock<std::mutex> lock(m_seqCacheLock);
+    if (m_seqCacheBudget == 0) {
+        return nullptr;
+    }
+    std::string version = GetCacheVersion(filename);
+    std::vector<std::pair<uint32_t, uint32_t>> ranges = GetCacheRanges(file);
+
+    auto it = m_seqCache.find(filename);
+    if (it != m_seqCache.end()) {
+        std::shared_ptr<CachedSequence> c = it->second;
+        if (c->inUse) {
+            return nullptr;
+        }
+        if (c->version == version && c->ranges == ranges && c->numFrames == file->getNumFrames()) {
+            // a partially recorded one carries on recording where it left off
+            if (c->complete) {
+                m_seqCacheHits++;
+            } else {
+                m_seqCacheMisses++;
+            }
+            c->inUse = true;
+            c->lastUsed = GetTimeMS();
+            return c;
+        }
+        // file or outputs changed
+        m_seqCacheSize -= c->size();
+        m_seqCache.erase(it);
+    }
+    m_seqCacheMisses++;
+
+    std::shared_ptr<CachedSequence> c = std::make_shared<CachedSequence>();
+    c->version = version;
+    c->ranges = ranges;
+    c->numFrames = file->getNumFrames();
+    for (auto& rng : ranges) {
+        c->frameSize += rng.second;
+    }
+    uint64_t size = c->size();
+    if (size == 0 || size > m_seqCacheBudget) {
+        return nullptr;
+    }
+    EvictCachedSequences(size);
+    if (m_seqCacheSize + size > m_seqCacheBudget) {
+        return nullptr;
+    }
+    c->data.reset(new (std::nothrow) uint8_t[size]);
+    if (!c->data) {
+        return nullptr;
+    }
+    c->recorded.resize(c->numFrames);
+    c->inUse = true;
+    c->lastUsed = GetTimeMS();
+    m_seqCache[filename] = c;
+    m_seqCacheSize += size;
+    LogDebug(VB_SEQUENCE, "Caching %s, %" PRIu64 " bytes, %" PRIu64 " of %" PRIu64 " in use\n",
+             filename.c_str(), size, m_seqCacheSize, m_seqCacheBudget);
+    return c;
+}
+
+bool Sequence::IsSequenceCached(const std::string& filename) {
+    std::unique_lock<std::mutex> lock(m_seqCacheLock);
+    auto it = m_seqCache.find(filename);
+    return it != m_seqCache.end() && it->second->complete && it->second->version == GetCacheVersion(filename);
+}
+
+// must be called with m_seqCacheLock held, drops the least recently
+// used sequences that aren't playing until needed more bytes fit
+void Sequence::EvictCachedSequences(uint64_t needed) {
+    while (!m_seqCache.empty() && (m_seqCacheSize + needed) > m_seqCacheBudget) {
+        auto oldest = m_seqCache.end();
+        for (auto it = m_seqCache.begin(); it != m_seqCache.end(); ++it) {
+            if (!it->second->inUse && (oldest == m_seqCache.end() || it->second->lastUsed < oldest->second->lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == m_seqCache.end()) {
+            return;
+        }
+        LogDebug(VB_SEQUENCE, "Dropping cached sequence %s\n", oldest->first.c_str());
+        m_seqCacheSize -= oldest->second->size();
+        m_seqCache.erase(oldest);
+    }
+}
+
+// must be called with readFileLock held
+FSEQFile::FrameData* Sequence::GetCachedFrame(uint32_t frame, FSEQFile::FrameData* recycle) {
+    if (frame >= m_playCache->numFrames) {
+        delete recycle;
+        return nullptr;
+    }
+    CachedFrameData* fd = dynamic_cast<CachedFrameData*>(recycle);
+    if (fd == nullptr) {
+        delete recycle;
+        return new CachedFrameData(frame, m_playCache);
+    }
+    fd->frame = frame;
+    fd->seq = m_playCache;
+    return fd;
+}
+
+// must be called with m_sequenceLock held right after data is loaded
+// into m_seqData
+void Sequence::RecordCachedFrame(FSEQFile::FrameData* data) {
+    CachedSequence* c = m_recordCache.get();
+    if (c == nullptr || data->frame >= c->numFrames || c->recorded[data->frame]) {
+        return;
+    }
+    uint8_t* dst = c->frameData(data->frame);
+    for (auto& rng : c->ranges) {
+        memcpy(dst, &m_seqData[rng.first], rng.second);
+        dst += rng.second;
+    }
+    c->recorded[data->frame] = true;
+    if (++c->recordedCount == c->numFrames) {
+        std::unique_lock<std::mutex> lock(m_seqCacheLock);
+        c->complete = true;
+        LogDebug(VB_SEQUENCE, "All %d frames of %s are cached\n", c->numFrames, m_seqFilename.c_str());
+    }
+}
+
+// must be called with m_sequenceLock and readFileLock held
+void Sequence::ReleaseCachedSequence() {
+    std::unique_lock<std::mutex> lock(m_seqCacheLock);
+    for (auto& c : { m_playCache, m_recordCache }) {
+        if (c) {
+            c->inUse = false;
+            c->lastUsed = GetTimeMS();
         }
     }
+    m_playCache.reset();
+    m_recordCache.reset();
 }
 
 int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int startSecond) {
@@ -267,6 +714,7 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     if (IsSequenceRunning())
         CloseSequenceFile();
 
+    std::unique_lock<std::mutex> readLock(readFileLock);
     std::unique_lock<std::mutex> lock(frameCacheLock);
     if (m_seqFile) {
         delete m_seqFile;
@@ -275,21 +723,19 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
         effectsOn.clear();
         effectsOff.clear();
     }
+    ReleaseCachedSequence();
+    readLock.unlock();
 
     m_seqStarting = 2;
-    m_doneRead = false;
-    m_lastFrameRead = -1;
-    if (startFrame) {
-        m_lastFrameRead = startFrame - 1;
-    }
     clearCaches();
+    RestartRead(startFrame);
     lock.unlock();
 
     m_seqPaused = 0;
     m_seqMSDuration = 0;
     m_seqMSElapsed = 0;
     m_seqMSRemaining = 0;
-    SetChannelOutputFrameNumber(m_lastFrameRead + 1);
+    SetChannelOutputFrameNumber(m_readStartFrame);
     if (m_readThread == nullptr) {
         m_readThread = new std::thread(ReadSequenceDataThread, this);
     }
@@ -340,7 +786,17 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     }
 
     m_seqFile = nullptr;
-    FSEQFile* seqFile = FSEQFile::openFSEQFile(tmpFilename);
+    std::vector<FSEQFile::FrameData*> preloadedFrames;
+    FSEQFile* seqFile = nullptr;
+    if (startFrame <= 0 && startSecond < 0) {
+        seqFile = TakePreloadedSequence(m_seqFilename, preloadedFrames);
+    } else {
+        ClearPreloadedSequence();
+    }
+    m_seqPreloaded = seqFile != nullptr;
+    if (seqFile == nullptr) {
+        seqFile = SequenceReencoder::INSTANCE.OpenSequenceFile(tmpFilename);
+    }
     if (seqFile == NULL) {
         LogErr(VB_SEQUENCE, "Error opening sequence file: %s. FSEQFile::openFSEQFile returned NULL\n",
                tmpFilename);
@@ -354,12 +810,16 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     if (startSecond >= 0) {
         int frame = startSecond * 1000;
         frame /= seqFile->getStepTime();
-        m_lastFrameRead = frame - 1;
-        if (m_lastFrameRead < -1)
-            m_lastFrameRead = -1;
+        lock.lock();
+        RestartRead(frame);
+        lock.unlock();
     }
 
-    seqFile->prepareRead(GetOutputRanges(), startFrame < 0 ? 0 : startFrame);
+    std::shared_ptr<CachedSequence> cached = GetCachedSequence(tmpFilename, seqFile);
+    bool playCached = cached && cached->complete;
+    if (!m_seqPreloaded && !playCached) {
+        seqFile->prepareRead(GetOutputRanges(), startFrame < 0 ? 0 : startFrame);
+    }
     // Calculate duration
     m_seqMSRemaining = seqFile->getNumFrames() * seqFile->getStepTime();
     m_seqMSDuration = m_seqMSRemaining;
@@ -367,11 +827,25 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     SetChannelOutputRefreshRate(m_seqRefreshRate);
 
     // start reading frames
+    readLock.lock();
     lock.lock();
     m_seqFile = seqFile;
+    if (playCached) {
+        m_playCache = cached;
+    } else {
+        m_recordCache = cached;
+    }
+    if (!preloadedFrames.empty()) {
+        // already read, the reader picks up after them
+        for (auto fd : preloadedFrames) {
+            frameCache.push_back(fd);
+        }
+        RestartRead(preloadedFrames.size());
+    }
     lock.unlock();
+    readLock.unlock();
     m_seqStarting = 1; // beyond header, read loop can start reading frames
-    frameLoadSignal.notify_all();
+    WakeReader();
     m_seqPaused = 0;
     m_seqSingleStep = 0;
     m_seqSingleStepBack = 0;
@@ -438,6 +912,18 @@ void Sequence::StartSequence() {
         m_seqStarting = 0;
         SetChannelOutputRefreshRate(m_seqRefreshRate);
         StartChannelOutputThread();
+
+        uint64_t end = m_seqEndTime.exchange(0);
+        if (end) {
+            uint64_t gap = GetTimeMicros() - end;
+            if (gap < SEQUENCE_MAX_TRANSITION_GAP_US) {
+                TimingStats& stats = m_seqPreloaded ? m_preloadedGaps : m_coldGaps;
+                stats.setDeadline(m_seqStepTime * 1000);
+                stats.addSample(gap);
+                LogDebug(VB_SEQUENCE, "Gap before %s sequence %s: %dus\n",
+                         m_seqPreloaded ? "preloaded" : "cold", m_seqFilename.c_str(), (int)gap);
+            }
+        }
     }
 
     std::map<std::string, std::string> keywords;
@@ -475,18 +961,20 @@ void Sequence::SeekSequenceFile(int frameNumber) {
         frameCache.push_front(pastFrameCache.back());
         pastFrameCache.pop_back();
     }
-    while (!frameCache.empty() && frameCache.front()->frame < frameNumber) {
-        if (frameCache.front() != m_lastFrameData)
-            delete frameCache.front();
+    FSEQFile::FrameData* f = NextCachedFrame();
+    while (f && f->frame < frameNumber) {
+        if (f != m_lastFrameData)
+            ReleaseFrameData(f);
         frameCache.pop_front();
+        f = NextCachedFrame();
     }
-    if (!frameCache.empty() && frameNumber < frameCache.front()->frame) {
+    if (f && frameNumber < f->frame) {
         clearCaches();
+        f = nullptr;
     }
-    if (frameCache.empty()) {
+    if (f == nullptr) {
         LogDebug(VB_SEQUENCE, "Seeking to %d.   Last read is %d\n", frameNumber, (int)m_lastFrameRead);
-        m_lastFrameRead = frameNumber - 1;
-        frameLoadSignal.notify_all();
+        RestartRead(frameNumber);
 
         if ((frameNumber < 100) && (getFPPmode() == REMOTE_MODE)) {
             m_numSeek++;
@@ -518,15 +1006,25 @@ int Sequence::IsSequenceRunning(const std::string& filename) {
 
 void Sequence::BlankSequenceData(bool clearBridge) {
     LogExcess(VB_SEQUENCE, "BlankSequenceData()\n");
+    uint64_t generation = channelDataChanges.getGeneration();
     for (auto& a : GetOutputRanges()) {
         memset(&m_seqData[a.first], 0, a.second);
+        channelDataChanges.markRestored(a.first, a.second, m_seqDataBlankGeneration);
     }
+    m_seqDataBlankGeneration = generation;
+    m_seqDataFrame = nullptr;
     if (m_bridgeData && clearBridge) {
         for (auto& a : GetOutputRanges()) {
             memset(&m_bridgeData[a.first], 0, a.second);
         }
         std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
         m_bridgeRanges.clear();
+        // they will be dropped from the active list on the next merge
+        for (uint32_t x = 0; x < m_bridgeUniverseCount; x++) {
+            m_bridgeUniverses[x].expires = 0;
+        }
+        m_nextBridgeExpire = 0;
+        m_bridgeIntervalsChanged = true;
     }
 
     m_dataProcessed = false;
@@ -571,17 +1069,12 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
             if (!pastFrameCache.empty()) {
                 frameCache.push_front(pastFrameCache.back());
                 pastFrameCache.pop_back();
-            } else if (frameCache.empty()) {
-                m_lastFrameRead = -1;
-                frameLoadSignal.notify_all();
+            } else if (NextCachedFrame() == nullptr) {
+                RestartRead(0);
             } else {
                 int f = frameCache.front()->frame - 1;
-                m_lastFrameRead = f - 1;
-                if (m_lastFrameRead < -1) {
-                    m_lastFrameRead = -1;
-                }
                 clearCaches();
-                frameLoadSignal.notify_all();
+                RestartRead(f);
             }
         } else {
             return;
@@ -592,17 +1085,32 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
         m_remoteBlankCount = 0;
 
         std::unique_lock<std::mutex> lock(frameCacheLock);
-        if (frameCache.empty() && !m_doneRead) {
+        FSEQFile::FrameData* data = NextCachedFrame();
+        if (data == nullptr && !IsReadDone()) {
             // wait up to the step time, if we don't have the frame, bail
+            lock.unlock();
             frameLoadSignal.notify_all();
-            frameLoadedSignal.wait_for(lock, std::chrono::milliseconds(m_seqStepTime - 1));
+            std::unique_lock<std::mutex> wlock(frameLoadedLock);
+            m_waitingForFrame = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            frameLoadedSignal.wait_for(wlock, std::chrono::milliseconds(m_seqStepTime - 1), [this]() {
+                return !m_readRing.empty() || IsReadDone() || m_shuttingDown;
+            });
+            m_waitingForFrame = false;
+            wlock.unlock();
+            lock.lock();
+            data = NextCachedFrame();
+        }
+        if (data == nullptr && IsReadDone()) {
+            // the reader only marks the read done after queueing the last
+            // frame, which could have happened since the ring was checked
+            data = NextCachedFrame();
         }
-        if (!frameCache.empty()) {
-            FSEQFile::FrameData* data = frameCache.front();
+        if (data) {
             frameCache.pop_front();
-            if (pastFrameCache.size() > 20) {
+            if (pastFrameCache.size() > SEQUENCE_PAST_FRAMECOUNT) {
                 if (pastFrameCache.front() != m_lastFrameData)
-                    delete pastFrameCache.front();
+                    ReleaseFrameData(pastFrameCache.front());
                 pastFrameCache.pop_front();
             }
             pastFrameCache.push_back(data);
@@ -610,24 +1118,29 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
             lock.unlock();
             frameLoadSignal.notify_all();
 
-            data->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+            LoadFrameData(data);
+            RecordCachedFrame(data);
             SetChannelOutputFrameNumber(data->frame);
             m_seqMSElapsed = data->frame * m_seqStepTime;
             m_seqMSRemaining = m_seqMSDuration - m_seqMSElapsed;
             m_dataProcessed = false;
-        } else if (m_doneRead) {
+        } else if (IsReadDone()) {
             lock.unlock();
             m_seqMSElapsed = m_seqMSDuration;
             m_seqMSRemaining = 0;
             CloseSequenceFile();
+            if (Player::INSTANCE.GetStatus() == FPP_STATUS_PLAYLIST_PLAYING) {
+                // see how long until the playlist starts the next one
+                m_seqEndTime = GetTimeMicros();
+            }
         } else {
             if (m_lastFrameRead > 0) {
-                // we'll have the read thread discard the frame
-                m_lastFrameRead++;
+                // we'll have the read thread skip a frame to catch back up
+                m_readSkipFrames++;
                 if (!pastFrameCache.empty()) {
                     // and copy the last frame data
                     SetLastFrameData(pastFrameCache.back());
-                    pastFrameCache.back()->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+                    LoadFrameData(pastFrameCache.back());
                     m_dataProcessed = false;
                 }
             }
@@ -661,78 +1174,59 @@ void Sequence::ProcessSequenceData(int ms) {
         // if we are then see if we can start with a pristine copy
         std::unique_lock<std::mutex> lock(frameCacheLock);
         if (m_lastFrameData)
-            m_lastFrameData->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+            LoadFrameData(m_lastFrameData);
     }
 
+    uint64_t stageStart = GetTimeMicros();
     std::unique_lock<std::mutex> bridgesLock(m_bridgeRangesLock);
-    if (m_bridgeData && !m_bridgeRanges.empty()) {
+    UpdateBridgeIntervals(GetTimeMS());
+    if (m_bridgeData && !m_bridgeIntervals.empty()) {
         // copy the latest bridge data to the sequence data
-        uint64_t nt = GetTimeMS();
-        std::map<uint32_t, uint32_t> rngs;
-        for (auto& a : m_bridgeRanges) {
-            BridgeRangeData& rd = a.second;
-            auto it = rd.expires.begin();
-            uint32_t len = 0;
-            while (it != rd.expires.end()) {
-                if (it->second < nt) {
-                    rd.expires.erase(it);
-                    it = rd.expires.begin();
-                } else {
-                    len = std::max(len, it->first);
-                    ++it;
-                }
-            }
-            if (len > 0) {
-                rngs[rd.startChannel] = len;
-            }
-        }
-        auto it = m_bridgeRanges.begin();
-        while (it != m_bridgeRanges.end()) {
-            if (it->second.expires.empty()) {
-                m_bridgeRanges.erase(it);
-                it = m_bridgeRanges.begin();
-            } else {
-                ++it;
-            }
-        }
-
-        uint32_t curStart = 0xFFFFFFFF;
-        uint32_t nextStart = 0xFFFFFFFF;
-        for (auto& a : rngs) {
-            if (curStart == 0xFFFFFFFF) {
-                curStart = a.first;
-                nextStart = a.first + a.second;
-            } else if (a.first > nextStart) {
-                memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
-                curStart = a.first;
-                nextStart = a.first + a.second;
-            } else if (a.first == nextStart) {
-                nextStart += a.second;
-            } else {
-                nextStart += a.second - (nextStart - a.first);
-            }
-        }
-        if (curStart != 0xFFFFFFFF) {
-            memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
+        for (auto& a : m_bridgeIntervals) {
+            memcpy(&m_seqData[a.first], &m_bridgeData[a.first], a.second);
+            channelDataChanges.markDirty(a.first, a.second);
         }
+        bridgesLock.unlock();
+        stageStart = RecordOutputStageTime(OutputStage::BridgeMerge, stageStart);
+    }
+    if (bridgesLock.owns_lock()) {
+        bridgesLock.unlock();
+    }
+    if (PluginManager::INSTANCE.hasChannelDataPlugins()) {
+        // no idea what the plugins will touch
+        channelDataChanges.markAllDirty();
     }
-    bridgesLock.unlock();
     PluginManager::INSTANCE.modifySequenceData(ms, (uint8_t*)m_seqData);
+    uint64_t pluginTime = GetTimeMicros() - stageStart;
 
-    if (IsEffectRunning())
+    if (IsEffectRunning()) {
+        stageStart = GetTimeMicros();
         OverlayEffects(m_seqData);
+        RecordOutputStageTime(OutputStage::Effects, stageStart);
+    }
 
+    stageStart = GetTimeMicros();
+    bool overlaying = false;
     if (SDLOutput::IsOverlayingVideo()) {
         SDLOutput::ProcessVideoOverlay(ms);
+        overlaying = true;
     }
     if (PixelOverlayManager::INSTANCE.hasActiveOverlays()) {
         PixelOverlayManager::INSTANCE.doOverlays((uint8_t*)m_seqData);
+        overlaying = true;
+    }
+    if (overlaying) {
+        stageStart = RecordOutputStageTime(OutputStage::Overlays, stageStart);
     }
 
-    if (ChannelTester::INSTANCE.Testing())
+    if (ChannelTester::INSTANCE.Testing()) {
+        channelDataChanges.markAllDirty();
         ChannelTester::INSTANCE.OverlayTestData(m_seqData);
+    }
 
+    stageStart = GetTimeMicros();
     PluginManager::INSTANCE.modifyChannelData(ms, (uint8_t*)m_seqData);
+    RecordOutputStageTime(OutputStage::PluginModify, stageStart - pluginTime);
 
     PrepareChannelData(m_seqData);
     m_dataProcessed = true;
@@ -800,6 +1294,7 @@ void Sequence::CloseSequenceFile(void) {
         multiSync->SendSeqSyncStopPacket(m_seqFilename);
 
     std::unique_lock<std::recursive_mutex> seqLock(m_sequenceLock);
+    m_seqEndTime = 0;
 
     std::unique_lock<std::mutex> readLock(readFileLock);
     if (m_seqFile) {
@@ -815,11 +1310,12 @@ void Sequence::CloseSequenceFile(void) {
         effectsOn.clear();
         effectsOff.clear();
     }
+    ReleaseCachedSequence();
     readLock.unlock();
 
     std::unique_lock<std::mutex> lock(frameCacheLock);
     clearCaches();
-    m_doneRead = true;
+    m_doneReadGeneration = m_readGeneration.load();
     m_lastFrameRead = -1;
     lock.unlock();
     frameLoadedSignal.notify_all();
@@ -835,15 +1331,22 @@ void Sequence::CloseSequenceFile(void) {
     }
 }
 
-void Sequence::SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t expireMS) {
+bool Sequence::AcceptBridgeData() {
     if (this->IsSequenceRunning()) {
         if (m_warn_if_bridging) {
             WarningHolder::AddWarningTimeout("Received bridging data while sequence is running.", 60);
         }
         if (m_prioritize_sequence_over_bridge) {
-            return;
+            return false;
         }
     }
+    return true;
+}
+
+void Sequence::SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t expireMS) {
+    if (!AcceptBridgeData()) {
+        return;
+    }
 
     if (!m_bridgeData) {
         m_bridgeData = (uint8_t*)calloc(1, FPPD_MAX_CHANNEL_NUM);
@@ -853,13 +1356,161 @@ void Sequence::SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t
     std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
     auto& a = m_bridgeRanges[startChannel];
     a.startChannel = startChannel;
-    a.expires[len] = expireMS;
+    if (a.expires.insert_or_assign(len, expireMS).second) {
+        m_bridgeIntervalsChanged = true;
+        m_nextBridgeExpire = std::min(m_nextBridgeExpire, expireMS);
+    }
     lock.unlock();
 
     setDataNotProcessed();
 }
 
+void Sequence::SetBridgeUniverses(const std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+    std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
+    m_activeBridgeUniverses.clear();
+    m_bridgeIntervalsChanged = true;
+    m_bridgeUniverseCount = 0;
+    m_bridgeUniverses.reset();
+    m_bridgeUniverseRing.reset();
+    if (ranges.empty()) {
+        return;
+    }
+    if (!m_bridgeData) {
+        m_bridgeData = (uint8_t*)calloc(1, FPPD_MAX_CHANNEL_NUM);
+    }
+    m_bridgeUniverses = std::make_unique<BridgeUniverse[]>(ranges.size());
+    for (auto& r : ranges) {
+        BridgeUniverse& u = m_bridgeUniverses[m_bridgeUniverseCount++];
+        u.startChannel = std::min(r.first, (uint32_t)FPPD_MAX_CHANNELS);
+        u.size = std::min(r.second, FPPD_MAX_CHANNELS - u.startChannel);
+    }
+    // each universe is only ever in the ring once so it can't fill up
+    m_bridgeUniverseRing = std::make_unique<SPSCRing<uint32_t>>(m_bridgeUniverseCount);
+    m_activeBridgeUniverses.reserve(m_bridgeUniverseCount);
+    m_bridgeIntervals.reserve(m_bridgeUniverseCount);
+}
+
+void Sequence::SetBridgeUniverseData(uint32_t idx, uint8_t* data, uint32_t len, uint64_t expireMS) {
+    if (idx >= m_bridgeUniverseCount || !AcceptBridgeData()) {
+        return;
+    }
+    BridgeUniverse& u = m_bridgeUniverses[idx];
+    len = std::min(len, u.size);
+    memcpy(&m_bridgeData[u.startChannel], data, len);
+    if (u.len != len) {
+        u.len = len;
+        m_bridgeUniverseLenChanged = true;
+    }
+    u.expires = expireMS;
+    if (!u.active && !u.active.exchange(true)) {
+        m_bridgeUniverseRing->push(idx);
+    }
+    setDataNotProcessed();
+}
+
+// must be called with m_bridgeRangesLock held
+void Sequence::UpdateBridgeIntervals(uint64_t now) {
+    bool changed = m_bridgeIntervalsChanged;
+    m_bridgeIntervalsChanged = false;
+    if (m_bridgeUniverseLenChanged.exchange(false)) {
+        changed = true;
+    }
+    uint32_t idx;
+    while (m_bridgeUniverseRing && m_bridgeUniverseRing->pop(idx)) {
+        m_activeBridgeUniverses.push_back(idx);
+        m_nextBridgeExpire = std::min(m_nextBridgeExpire, m_bridgeUniverses[idx].expires.load());
+        changed = true;
+    }
+
+    // expire times only ever move forward so nothing needs to be checked
+    // until the earliest one seen last time has passed
+    if (now >= m_nextBridgeExpire) {
+        uint64_t next = std::numeric_limits<uint64_t>::max();
+        int x = 0;
+        while (x < m_activeBridgeUniverses.size()) {
+            BridgeUniverse& u = m_bridgeUniverses[m_activeBridgeUniverses[x]];
+            if (u.expires < now) {
+                u.active = false;
+                // data may have arrived between the check and clearing active,
+                // if the receiver didn't see the cleared flag it's still ours
+                if (u.expires < now || u.active.exchange(true)) {
+                    m_activeBridgeUniverses[x] = m_activeBridgeUniverses.back();
+                    m_activeBridgeUniverses.pop_back();
+                    changed = true;
+                    continue;
+                }
+            }
+            next = std::min(next, u.expires.load());
+            ++x;
+        }
+        auto it = m_bridgeRanges.begin();
+        while (it != m_bridgeRanges.end()) {
+            auto& expires = it->second.expires;
+            auto eit = expires.begin();
+            while (eit != expires.end()) {
+                if (eit->second < now) {
+                    eit = expires.erase(eit);
+                    changed = true;
+                } else {
+                    next = std::min(next, eit->second);
+                    ++eit;
+                }
+            }
+            if (expires.empty()) {
+                it = m_bridgeRanges.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_nextBridgeExpire = next;
+    }
+    if (!changed) {
+        return;
+    }
+
+    m_bridgeIntervals.clear();
+    for (auto idx : m_activeBridgeUniverses) {
+        BridgeUniverse& u = m_bridgeUniverses[idx];
+        if (u.len) {
+            m_bridgeIntervals.emplace_back(u.startChannel, u.len.load());
+        }
+    }
+    for (auto& a : m_bridgeRanges) {
+        // the expires map is ordered by length
+        m_bridgeIntervals.emplace_back(a.second.startChannel, a.second.expires.rbegin()->first);
+    }
+    std::sort(m_bridgeIntervals.begin(), m_bridgeIntervals.end());
+    // coalesce overlapping and adjacent ranges
+    int out = -1;
+    for (auto& a : m_bridgeIntervals) {
+        if (out >= 0 && a.first <= m_bridgeIntervals[out].first + m_bridgeIntervals[out].second) {
+            uint32_t end = std::max(m_bridgeIntervals[out].first + m_bridgeIntervals[out].second, a.first + a.second);
+            m_bridgeIntervals[out].second = end - m_bridgeIntervals[out].first;
+        } else {
+            m_bridgeIntervals[++out] = a;
+        }
+    }
+    m_bridgeIntervals.resize(out + 1);
+}
+
+void Sequence::GetStats(Json::Value& result) {
+    result["framePool"]["size"] = (Json::UInt64)m_frameDataPool.size();
+    result["framePool"]["hits"] = (Json::UInt64)m_framePoolHits;
+    result["framePool"]["misses"] = (Json::UInt64)m_framePoolMisses;
+    result["readAhead"] = (Json::UInt64)m_readRing.size();
+    m_readTimes.toJson(result["readTimes"]);
+    m_preloadedGaps.toJson(result["transitionGaps"]["preloaded"]);
+    m_coldGaps.toJson(result["transitionGaps"]["cold"]);
+
+    std::unique_lock<std::mutex> lock(m_seqCacheLock);
+    result["sequenceCache"]["hits"] = (Json::UInt64)m_seqCacheHits;
+    result["sequenceCache"]["misses"] = (Json::UInt64)m_seqCacheMisses;
+    result["sequenceCache"]["bytes"] = (Json::UInt64)m_seqCacheSize;
+    result["sequenceCache"]["budget"] = (Json::UInt64)m_seqCacheBudget;
+    result["sequenceCache"]["sequences"] = (Json::UInt64)m_seqCache.size();
+}
+
 bool Sequence::hasBridgeData() {
     std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
-    return !m_bridgeRanges.empty();
+    return !m_bridgeIntervals.empty() || !m_bridgeRanges.empty() || (m_bridgeUniverseRing && !m_bridgeUniverseRing->empty());
 }
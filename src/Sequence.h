@@ -16,13 +16,16 @@
 
 #include <atomic>
 #include <condition_variable>
-#include <list>
+#include <deque>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 #include "fseq/FSEQFile.h"
+#include "util/SPSCRing.h"
+#include "util/TimingStats.h"
 
 #define FPPD_MAX_CHANNELS (8192 * 1024)
 #define DATA_DUMP_SIZE 28
@@ -41,6 +44,11 @@ public:
     int IsSequenceRunning(void);
     int IsSequenceRunning(const std::string& filename);
     int OpenSequenceFile(const std::string& filename, int startFrame = 0, int startSecond = -1);
+    // Open the sequence and read its first frames in the background so a
+    // later OpenSequenceFile of it from the start just swaps it in
+    void PreloadSequenceFile(const std::string& filename);
+    // Drop anything preloaded, nothing is going to play it
+    void ClearPreloadedSequence();
     void StartSequence(const std::string& filename, int startFrame);
     void StartSequence();
     void ProcessSequenceData(int ms);
@@ -70,6 +78,14 @@ public:
 
     void SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t expireMS);
 
+    // Fixed bridge ranges (E1.31/ArtNet universes) are registered up front,
+    // receiving data for one is then just a copy and storing its expire time.
+    // Both must be called from the same thread.
+    void SetBridgeUniverses(const std::vector<std::pair<uint32_t, uint32_t>>& ranges);
+    void SetBridgeUniverseData(uint32_t idx, uint8_t* data, uint32_t len, uint64_t expireMS);
+
+    void GetStats(Json::Value& result);
+
 private:
     void ProcessVariableHeaders();
     void SetLastFrameData(FSEQFile::FrameData* data);
@@ -90,6 +106,33 @@ private:
     std::map<uint64_t, BridgeRangeData> m_bridgeRanges;
     std::mutex m_bridgeRangesLock;
     uint8_t* m_bridgeData;
+    bool AcceptBridgeData();
+
+    class BridgeUniverse {
+    public:
+        uint32_t startChannel = 0;
+        uint32_t size = 0;
+        std::atomic_uint32_t len = 0;
+        std::atomic_uint64_t expires = 0;
+        std::atomic_bool active = false; // in m_activeBridgeUniverses or m_bridgeUniverseRing
+    };
+    // Universes are pushed onto the ring by the receiver when they go from
+    // expired to active, the output side moves them to m_activeBridgeUniverses
+    // (under m_bridgeRangesLock) and drops them again once they expire so
+    // idle universes are never looked at.
+    std::unique_ptr<BridgeUniverse[]> m_bridgeUniverses;
+    uint32_t m_bridgeUniverseCount = 0;
+    std::unique_ptr<SPSCRing<uint32_t>> m_bridgeUniverseRing;
+    std::vector<uint32_t> m_activeBridgeUniverses;
+    std::atomic_bool m_bridgeUniverseLenChanged = false;
+
+    // Sorted, coalesced (start, len) of everything in m_bridgeRanges and
+    // m_activeBridgeUniverses.  It's only rebuilt when a range starts or
+    // expires so merging the bridge data is a single pass over it.
+    std::vector<std::pair<uint32_t, uint32_t>> m_bridgeIntervals;
+    bool m_bridgeIntervalsChanged = false;
+    uint64_t m_nextBridgeExpire = 0; // nothing can expire before this
+    void UpdateBridgeIntervals(uint64_t now);
 
     FSEQFile* m_seqFile;
 
@@ -108,18 +151,104 @@ private:
     std::recursive_mutex m_sequenceLock;
 
     std::atomic_int m_lastFrameRead;
-    volatile bool m_doneRead;
     volatile bool m_shuttingDown;
     std::thread* m_readThread;
-    std::list<FSEQFile::FrameData*> frameCache;
-    std::list<FSEQFile::FrameData*> pastFrameCache;
+    std::deque<FSEQFile::FrameData*> frameCache;
+    std::deque<FSEQFile::FrameData*> pastFrameCache;
     FSEQFile::FrameData* m_lastFrameData;
     void clearCaches();
+
+    // Copies a frame into m_seqData and marks what changed in
+    // channelDataChanges.  If the same frame is being copied in again
+    // (reprocessing, paused, etc...) only what was written over it since
+    // is marked.  Blanking is handled the same way.
+    void LoadFrameData(FSEQFile::FrameData* data);
+    std::atomic<FSEQFile::FrameData*> m_seqDataFrame;
+    uint64_t m_seqDataFrameGeneration;
+    uint64_t m_seqDataBlankGeneration;
+
+    // Frames read by the ReadFramesLoop thread are handed to the consumer
+    // side (anything holding frameCacheLock) through m_readRing so the reader
+    // never needs frameCacheLock.  Each frame is tagged with the read
+    // generation it was read for, seeking just starts a new generation and
+    // anything still in flight from the old one is dropped by the consumer.
+    class ReadFrame {
+    public:
+        FSEQFile::FrameData* data = nullptr;
+        uint32_t generation = 0;
+    };
+    SPSCRing<ReadFrame> m_readRing;
+    std::atomic_uint32_t m_readGeneration;
+    std::atomic_uint32_t m_doneReadGeneration;
+    std::atomic_int m_readStartFrame;
+    std::atomic_int m_readSkipFrames;
+    std::atomic_bool m_waitingForFrame;
+    void RestartRead(int frame);
+    bool IsReadDone() const { return m_doneReadGeneration == m_readGeneration; }
+    FSEQFile::FrameData* NextCachedFrame();
+    void WakeReader();
+    TimingStats m_readTimes;
+
+    // FrameData objects that are no longer in use are passed back to the
+    // reader to be refilled by FSEQFile::getFrame instead of reallocated
+    SPSCRing<FSEQFile::FrameData*> m_frameDataPool;
+    void ReleaseFrameData(FSEQFile::FrameData* data);
+    void ClearFrameDataPool();
+    std::atomic_uint64_t m_framePoolHits;
+    std::atomic_uint64_t m_framePoolMisses;
     std::mutex frameCacheLock;
     std::mutex readFileLock; // lock for just the stuff needed to read from the file (m_seqFile variable)
+    std::mutex frameLoadLock;   // only used for the reader to wait on frameLoadSignal
+    std::mutex frameLoadedLock; // only used for the consumer to wait on frameLoadedSignal
     std::condition_variable frameLoadSignal;
     std::condition_variable frameLoadedSignal;
 
+    // Sequence opened ahead of time by PreloadSequenceFile.  Only the
+    // preload thread touches it until it has been joined.
+    class PreloadedSequence {
+    public:
+        ~PreloadedSequence();
+
+        std::string filename;
+        FSEQFile* file = nullptr;
+        std::vector<FSEQFile::FrameData*> frames;
+        std::atomic_bool cancel = false;
+    };
+    std::unique_ptr<PreloadedSequence> m_preload;
+    std::thread* m_preloadThread;
+    std::mutex m_preloadLock;
+    void PreloadFrames(PreloadedSequence* p);
+    FSEQFile* TakePreloadedSequence(const std::string& filename, std::vector<FSEQFile::FrameData*>& frames);
+
+    // Time between a sequence running out of frames during a playlist and
+    // the next one starting, split by whether the next one was preloaded
+    std::atomic_uint64_t m_seqEndTime;
+    bool m_seqPreloaded;
+    TimingStats m_preloadedGaps;
+    TimingStats m_coldGaps;
+
+    // Decoded frames (just the channels that are output) of recently played
+    // sequences are kept up to m_seqCacheBudget bytes so replaying them
+    // doesn't read or decompress anything.  Frames are recorded as they are
+    // played, once every frame has been seen the reader hands out frames
+    // from the cache instead of the file.
+    class CachedSequence;
+    class CachedFrameData;
+    std::map<std::string, std::shared_ptr<CachedSequence>> m_seqCache;
+    std::mutex m_seqCacheLock;
+    uint64_t m_seqCacheSize;
+    uint64_t m_seqCacheBudget;
+    std::atomic_uint64_t m_seqCacheHits;
+    std::atomic_uint64_t m_seqCacheMisses;
+    std::shared_ptr<CachedSequence> m_playCache;   // read from by the reader, under readFileLock
+    std::shared_ptr<CachedSequence> m_recordCache; // recorded into, under m_sequenceLock
+    std::shared_ptr<CachedSequence> GetCachedSequence(const std::string& filename, FSEQFile* file);
+    bool IsSequenceCached(const std::string& filename);
+    void EvictCachedSequences(uint64_t needed);
+    FSEQFile::FrameData* GetCachedFrame(uint32_t frame, FSEQFile::FrameData* recycle);
+    void RecordCachedFrame(FSEQFile::FrameData* data);
+    void ReleaseCachedSequence();
+
     std::map<uint32_t, std::vector<std::string>> commandPresets;
     std::map<uint32_t, std::vector<std::string>> effectsOn;
     std::map<uint32_t, std::vector<std::string>> effectsOff;
@@ -0,0 +1,263 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+#include "log.h"
+#include "Sequence.h"
+#include "settings.h"
+#include "channeloutput/ChannelOutputSetup.h"
+#include "fseq/FSEQFile.h"
+
+#include "SequenceReencoder.h"
+
+// how often the sequence directory is checked for new or changed sequences
+#define REENCODE_SCAN_INTERVAL_S 60
+// sequences modified more recently than this may still be uploading
+#define REENCODE_MIN_AGE_S 30
+
+#ifndef PLATFORM_OSX
+// glibc has no ioprio_set wrapper, these are from linux/ioprio.h
+#define REENCODE_IOPRIO_WHO_PROCESS 1
+#define REENCODE_IOPRIO_CLASS_IDLE 3
+#define REENCODE_IOPRIO_CLASS_SHIFT 13
+#endif
+
+SequenceReencoder SequenceReencoder::INSTANCE;
+
+void SequenceReencoder::Initialize() {
+    enabled = getSettingInt("ReencodeSequences", 0) != 0;
+    registerSettingsListener("SequenceReencoder", "ReencodeSequences", [this](const std::string& value) {
+        // set under the lock so the thread can't miss it between checking
+        // and starting to wait
+        std::unique_lock<std::mutex> l(lock);
+        enabled = value == "1";
+        l.unlock();
+        signal.notify_all();
+    });
+    running = true;
+    thread = new std::thread([this]() { ReencodeLoop(); });
+}
+
+void SequenceReencoder::Cleanup() {
+    unregisterSettingsListener("SequenceReencoder", "ReencodeSequences");
+    if (thread) {
+        std::unique_lock<std::mutex> l(lock);
+        running = false;
+        l.unlock();
+        signal.notify_all();
+        thread->join();
+        delete thread;
+        thread = nullptr;
+    }
+}
+
+std::string SequenceReencoder::GetReencodedName(const std::string& filename) {
+    std::filesystem::path p(filename);
+    return (p.parent_path() / ("." + p.filename().string())).string();
+}
+
+// Anything that would make the re-encoded copy stale: the original being
+// replaced or the outputs changing
+std::string SequenceReencoder::GetSourceVersion(const std::string& filename) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return "";
+    }
+    return std::to_string(st.st_mtime) + ":" + std::to_string(st.st_size) + ":" + GetOutputRangesAsString();
+}
+
+// Only files written by this have the 'FO' header, anything else that
+// happens to be named like one (macOS ._ files, etc...) is left alone
+bool SequenceReencoder::IsReencodedFile(const std::string& filename) {
+    std::unique_ptr<FSEQFile> f(FSEQFile::openFSEQFile(filename));
+    if (f) {
+        for (auto& h : f->getVariableHeaders()) {
+            if (h.code[0] == 'F' && h.code[1] == 'O') {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SequenceReencoder::IsPlaying() {
+    return sequence && sequence->IsSequenceRunning();
+}
+
+FSEQFile* SequenceReencoder::OpenSequenceFile(const std::string& filename) {
+    std::string reencoded = GetReencodedName(filename);
+    if (enabled && FileExists(reencoded)) {
+        std::string version = GetSourceVersion(filename);
+        FSEQFile* f = FSEQFile::openFSEQFile(reencoded);
+        if (f) {
+            for (auto& h : f->getVariableHeaders()) {
+                if (h.code[0] == 'F' && h.code[1] == 'O' && version == (const char*)&h.getData()[0]) {
+                    LogDebug(VB_SEQUENCE, "Using re-encoded copy of %s\n", filename.c_str());
+                    return f;
+                }
+            }
+            delete f;
+        }
+    }
+    return FSEQFile::openFSEQFile(filename);
+}
+
+void SequenceReencoder::ReencodeLoop() {
+    SetThreadName("FPP-Reencode");
+#ifndef PLATFORM_OSX
+    // stay out of the way of playback, both for the CPU and for reading
+    // the card the playing sequence is streamed from
+    setpriority(PRIO_PROCESS, gettid(), 19);
+    syscall(SYS_ioprio_set, REENCODE_IOPRIO_WHO_PROCESS, gettid(),
+            REENCODE_IOPRIO_CLASS_IDLE << REENCODE_IOPRIO_CLASS_SHIFT);
+#endif
+
+    // starts out as if it was enabled so copies are also removed if it was
+    // turned off while fppd wasn't running
+    bool wasEnabled = true;
+    std::unique_lock<std::mutex> l(lock);
+    while (running) {
+        bool en = enabled;
+        l.unlock();
+        if (en) {
+            ReencodeSequences();
+        } else if (wasEnabled) {
+            RemoveReencodedSequences(false);
+        }
+        wasEnabled = en;
+        l.lock();
+        auto changed = [this, en]() { return !running || en != enabled; };
+        if (en) {
+            signal.wait_for(l, std::chrono::seconds(REENCODE_SCAN_INTERVAL_S), changed);
+        } else {
+            // nothing to do until it's turned on
+            signal.wait(l, changed);
+        }
+    }
+}
+
+// Removes the copies of sequences that have been deleted, or all of them,
+// along with anything left behind by a re-encode that didn't finish.
+// Only files with the 'FO' header are removed.
+void SequenceReencoder::RemoveReencodedSequences(bool orphansOnly) {
+    std::error_code ec;
+    for (auto& entry : std::filesystem::directory_iterator(FPP_DIR_SEQUENCE(""), ec)) {
+        std::string name = entry.path().filename().string();
+        if (name[0] != '.') {
+            continue;
+        }
+        bool stale = false;
+        if (endsWith(name, ".fseq.tmp")) {
+            stale = true;
+        } else if (endsWith(name, ".fseq")) {
+            stale = !orphansOnly || !FileExists(FPP_DIR_SEQUENCE("/" + name.substr(1)));
+        }
+        if (stale && IsReencodedFile(entry.path().string())) {
+            LogDebug(VB_SEQUENCE, "Removing re-encoded sequence %s\n", name.c_str());
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+void SequenceReencoder::ReencodeSequences() {
+    RemoveReencodedSequences(true);
+
+    std::vector<std::string> sequences;
+    std::error_code ec;
+    for (auto& entry : std::filesystem::directory_iterator(FPP_DIR_SEQUENCE(""), ec)) {
+        std::string name = entry.path().filename().string();
+        if (name[0] != '.' && endsWith(name, ".fseq") && entry.is_regular_file(ec)) {
+            sequences.push_back(entry.path().string());
+        }
+    }
+    for (auto& s : sequences) {
+        if (!running || !enabled || IsPlaying()) {
+            // anything left is picked up by a later scan
+            return;
+        }
+        ReencodeSequence(s);
+    }
+}
+
+void SequenceReencoder::ReencodeSequence(const std::string& filename) {
+    std::string version = GetSourceVersion(filename);
+    if (version.empty() || skipped[filename] == version) {
+        return;
+    }
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0 || time(nullptr) - st.st_mtime < REENCODE_MIN_AGE_S) {
+        return;
+    }
+    std::string reencoded = GetReencodedName(filename);
+    if (FileExists(reencoded)) {
+        std::unique_ptr<FSEQFile> f(FSEQFile::openFSEQFile(reencoded));
+        if (f) {
+            for (auto& h : f->getVariableHeaders()) {
+                if (h.code[0] == 'F' && h.code[1] == 'O' && version == (const char*)&h.getData()[0]) {
+                    return;
+                }
+            }
+        }
+    }
+
+    // only worth it if it gets rid of channels that are never output
+    const std::vector<std::pair<uint32_t, uint32_t>>& ranges = GetOutputRanges();
+    {
+        std::unique_ptr<FSEQFile> src(FSEQFile::openFSEQFile(filename));
+        uint32_t kept = 0;
+        if (src) {
+            for (auto& rng : ranges) {
+                if (rng.first < src->getMaxChannel()) {
+                    kept += std::min(rng.second, src->getMaxChannel() - rng.first);
+                }
+            }
+        }
+        if (!src || kept >= src->getChannelCount()) {
+            skipped[filename] = version;
+            if (IsReencodedFile(reencoded)) {
+                remove(reencoded.c_str());
+            }
+            return;
+        }
+    }
+
+    FSEQFile::VariableHeader header;
+    header.code[0] = 'F';
+    header.code[1] = 'O';
+    header.resizeData(version.size() + 1);
+    strcpy((char*)&header.getData()[0], version.c_str());
+
+    LogInfo(VB_SEQUENCE, "Re-encoding %s for channels %s\n", filename.c_str(), GetOutputRangesAsString(true, true).c_str());
+    uint64_t start = GetTimeMS();
+    // a sequence starting to play cancels it, it is retried later.  That
+    // also keeps playback from skewing the block size timing.
+    auto cancelled = [this]() { return !running || !enabled || IsPlaying(); };
+    if (!FSEQFile::reencodeFSEQFile(filename, reencoded, ranges, 0, { header }, cancelled)) {
+        if (!cancelled()) {
+            LogWarn(VB_SEQUENCE, "Could not re-encode %s\n", filename.c_str());
+            skipped[filename] = version;
+        }
+        return;
+    }
+    LogInfo(VB_SEQUENCE, "Re-encoded %s in %dms\n", filename.c_str(), (int)(GetTimeMS() - start));
+}
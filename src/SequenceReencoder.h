@@ -0,0 +1,64 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class FSEQFile;
+
+// Keeps a copy of each sequence in the sequence directory re-encoded for
+// this FPP instance: only the channels it outputs, in compression blocks
+// sized for how fast this CPU decompresses them.  The copy is written next
+// to the original as ".<name>.fseq" by a low priority background thread
+// and is only used while it still matches the original and the outputs.
+class SequenceReencoder {
+public:
+    static SequenceReencoder INSTANCE;
+
+    void Initialize();
+    void Cleanup();
+
+    // Opens the re-encoded copy of the sequence if there is a current one,
+    // otherwise the sequence itself
+    FSEQFile* OpenSequenceFile(const std::string& filename);
+
+private:
+    SequenceReencoder() {}
+    ~SequenceReencoder() {}
+
+    SequenceReencoder(const SequenceReencoder&) = delete;
+    SequenceReencoder& operator=(const SequenceReencoder&) = delete;
+
+    void ReencodeLoop();
+    void ReencodeSequences();
+    void RemoveReencodedSequences(bool orphansOnly);
+    void ReencodeSequence(const std::string& filename);
+
+    static std::string GetReencodedName(const std::string& filename);
+    static bool IsReencodedFile(const std::string& filename);
+    static std::string GetSourceVersion(const std::string& filename);
+    static bool IsPlaying();
+
+    std::atomic_bool enabled = false;
+    std::atomic_bool running = false;
+    std::thread* thread = nullptr;
+    std::mutex lock;
+    std::condition_variable signal;
+
+    // versions of sequences that aren't worth re-encoding (or failed)
+    std::map<std::string, std::string> skipped;
+};
@@ -173,7 +173,6 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
         unsigned char* cur = channelData + startChannel - 1;
         int start = 0;
         bool anySkipped = false;
-        bool allSkipped = true;
 
         std::vector<struct mmsghdr>& msgs = messages[ARTNET_DEST_PORT];
         for (int x = 0; x < universeCount; x++) {
@@ -189,7 +188,6 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
 
                 anHeaders[x][ARTNET_SEQUENCE_INDEX] = sequenceNumber;
                 anIovecs[x * 2 + 1].iov_base = (void*)cur;
-                allSkipped = false;
             } else {
                 anySkipped = true;
             }
@@ -203,9 +201,6 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
         if (anySkipped) {
             skippedFrames++;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 void ArtNetOutputData::PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
@@ -48,6 +48,11 @@ public:
     virtual void OverlayTestData(unsigned char* channelData, int cycleNum, float percentOfCycle, int testType, const Json::Value& config) {}
     virtual bool SupportsTesting() const { return false; }
 
+    // Output specific counters (packets sent/skipped, etc...) to report
+    // along with the output timing stats
+    virtual void GetStats(Json::Value& result) {}
+    virtual void ResetStats() {}
+
 protected:
     virtual void DumpConfig(void);
     virtual void ConvertToCSV(Json::Value config, char* configStr);
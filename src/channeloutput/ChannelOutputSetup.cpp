@@ -20,12 +20,14 @@
 #include <string.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <fstream>
 #include <sstream>
 #include <string>
 
 #include "ChannelOutput.h"
 #include "ChannelOutputSetup.h"
+#include "channeloutputthread.h"
 #include "Sequence.h"
 #include "Warnings.h"
 #include "common.h"
@@ -37,6 +39,8 @@
 #include "../Plugins.h"
 #include "../config.h"
 #include "../MultiSync.h"
+#include "../util/DirtyRanges.h"
+#include "../util/TimingStats.h"
 
 // old style that still need porting
 #include "FPD.h"
@@ -57,6 +61,9 @@ public:
     void* privData = nullptr;
     std::string sourceFile;
 
+    TimingStats prepTimes;
+    TimingStats sendTimes;
+
     std::atomic<FPPChannelOutputInstance*> prev;
     std::atomic<FPPChannelOutputInstance*> next;
 };
@@ -77,6 +84,108 @@ inline void addChannelOutput(FPPChannelOutputInstance* inst) {
 }
 
 OutputProcessors outputProcessors;
+DirtyRanges channelDataChanges(FPPD_MAX_CHANNEL_NUM);
+
+static void PrepOutput(FPPChannelOutputInstance* inst, unsigned char* channelData) {
+    uint64_t start = GetTimeMicros();
+    inst->output->PrepData(channelData);
+    inst->prepTimes.addSample(GetTimeMicros() - start);
+}
+
+// Optional (ParallelOutputPrep setting) pool of worker threads that run
+// the PrepData for the outputs in parallel.  Outputs don't share any state
+// during PrepData so they can each work while the others do.  The calling
+// thread also works through the outputs and waits for all of them to be
+// done before returning so SendData is never called while prepping.
+class OutputPrepPool {
+public:
+    OutputPrepPool() {}
+    ~OutputPrepPool() { stop(); }
+
+    bool isRunning() const { return !m_threads.empty(); }
+    void start(int numThreads) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stop = false;
+        for (int x = 0; x < numThreads; x++) {
+            m_threads.emplace_back([this, x]() {
+                char name[24];
+                snprintf(name, sizeof(name), "FPP-OutPrep%d", x);
+                SetThreadName(name);
+                workerLoop();
+            });
+        }
+        LogDebug(VB_CHANNELOUT, "Started %d threads for parallel output prep\n", numThreads);
+    }
+    void stop() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stop = true;
+        lock.unlock();
+        m_workSignal.notify_all();
+        for (auto& t : m_threads) {
+            t.join();
+        }
+        m_threads.clear();
+    }
+
+    void prepOutputs(FPPChannelOutputInstance** outputs, uint32_t count, unsigned char* channelData) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_jobs = outputs;
+        m_numJobs = count;
+        m_channelData = channelData;
+        m_nextJob = 0;
+        m_doneJobs = 0;
+        m_generation++;
+        lock.unlock();
+        m_workSignal.notify_all();
+
+        runJobs();
+
+        lock.lock();
+        m_doneSignal.wait(lock, [this]() { return m_doneJobs == m_numJobs && m_activeWorkers == 0; });
+        m_jobs = nullptr;
+    }
+
+private:
+    void workerLoop() {
+        uint32_t generation = 0;
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (!m_stop) {
+            if (m_generation != generation && m_jobs) {
+                generation = m_generation;
+                m_activeWorkers++;
+                lock.unlock();
+                runJobs();
+                lock.lock();
+                m_activeWorkers--;
+                m_doneSignal.notify_all();
+            } else {
+                m_workSignal.wait(lock);
+            }
+        }
+    }
+    void runJobs() {
+        for (uint32_t i = m_nextJob++; i < m_numJobs; i = m_nextJob++) {
+            PrepOutput(m_jobs[i], m_channelData);
+            m_doneJobs++;
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock;
+    std::condition_variable m_workSignal;
+    std::condition_variable m_doneSignal;
+    bool m_stop = false;
+    uint32_t m_generation = 0;
+    int m_activeWorkers = 0;
+
+    FPPChannelOutputInstance** m_jobs = nullptr;
+    uint32_t m_numJobs = 0;
+    unsigned char* m_channelData = nullptr;
+    std::atomic<uint32_t> m_nextJob = 0;
+    std::atomic<uint32_t> m_doneJobs = 0;
+};
+static OutputPrepPool outputPrepPool;
+static std::atomic_bool parallelOutputPrep(false);
 
 bool HasChannelOutputs() {
     return channelOutputs.load() != nullptr;
@@ -499,6 +608,12 @@ int InitializeChannelOutputs(void) {
         co = co->next;
     }
     LogDebug(VB_CHANNELOUT, "%d Channel Outputs configured\n", count);
+
+    parallelOutputPrep = getSettingInt("ParallelOutputPrep");
+    registerSettingsListener("ChannelOutputSetup", "ParallelOutputPrep", [](const std::string& value) {
+        parallelOutputPrep = getSettingInt("ParallelOutputPrep");
+    });
+
     std::string opfilename = FPP_DIR_CONFIG("/outputprocessors.json");
     FileMonitor::INSTANCE.AddFile("outputprocessors.json", opfilename, [opfilename]() {
                              Json::Value newRoot;
@@ -546,13 +661,37 @@ std::set<std::string> GetOutputTypes() {
     return ret;
 }
 int PrepareChannelData(char* channelData) {
+    uint64_t start = GetTimeMicros();
     outputProcessors.ProcessData((unsigned char*)channelData);
+    RecordOutputStageTime(OutputStage::OutputProcessors, start);
+
+    if (parallelOutputPrep) {
+        // only called from the output thread so the list can be reused
+        static std::vector<FPPChannelOutputInstance*> toPrep;
+        toPrep.clear();
+        for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
+            if (inst->output) {
+                toPrep.push_back(inst);
+            }
+        }
+        if (toPrep.size() > 1) {
+            if (!outputPrepPool.isRunning()) {
+                int threads = std::min((int)std::thread::hardware_concurrency() - 1, 3);
+                outputPrepPool.start(std::max(threads, 1));
+            }
+            outputPrepPool.prepOutputs(&toPrep[0], toPrep.size(), (unsigned char*)channelData);
+            channelDataChanges.nextGeneration();
+            return 0;
+        }
+    }
     for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
-        auto output = inst->output;
-        if (output) {
-            output->PrepData((unsigned char*)channelData);
+        if (inst->output) {
+            PrepOutput(inst, (unsigned char*)channelData);
         }
     }
+    // outputs have seen everything written so far, anything written from
+    // here on is part of the next frame
+    channelDataChanges.nextGeneration();
     return 0;
 }
 
@@ -572,6 +711,7 @@ int SendChannelData(const char* channelData) {
 
     for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
         auto output = inst->output;
+        uint64_t start = GetTimeMicros();
         if (inst->outputOld) {
             inst->outputOld->send(
                 inst->privData,
@@ -580,11 +720,46 @@ int SendChannelData(const char* channelData) {
         } else if (output) {
             output->SendData((unsigned char*)(channelData + inst->startChannel));
         }
+        inst->sendTimes.addSample(GetTimeMicros() - start);
     }
 
     return 0;
 }
 
+void GetChannelOutputTimingStats(Json::Value& result) {
+    result = Json::Value(Json::ValueType::arrayValue);
+    for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
+        Json::Value v;
+        if (inst->output) {
+            v["type"] = inst->output->GetOutputType();
+        } else {
+            v["type"] = inst->sourceFile;
+        }
+        v["startChannel"] = inst->startChannel;
+        v["channelCount"] = inst->channelCount;
+        inst->prepTimes.toJson(v["prep"]);
+        inst->sendTimes.toJson(v["send"]);
+        if (inst->output) {
+            Json::Value stats;
+            inst->output->GetStats(stats);
+            if (!stats.isNull()) {
+                v["stats"] = stats;
+            }
+        }
+        result.append(v);
+    }
+}
+
+void ResetChannelOutputTimingStats() {
+    for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
+        inst->prepTimes.reset();
+        inst->sendTimes.reset();
+        if (inst->output) {
+            inst->output->ResetStats();
+        }
+    }
+}
+
 /*
  *
  */
@@ -629,6 +804,7 @@ void StoppingOutput(void) {
  *
  */
 void CloseChannelOutputs(void) {
+    outputPrepPool.stop();
     for (auto inst = channelOutputs.load(); inst != nullptr; inst = inst->next) {
         auto output = inst->output;
         if (inst->outputOld) {
@@ -18,12 +18,18 @@
 #include <vector>
 
 class ChannelOutput;
+class DirtyRanges;
 class OutputProcessors;
 
 extern unsigned long channelOutputFrame;
 extern float mediaElapsedSeconds;
 extern OutputProcessors outputProcessors;
 
+// Anything that writes to the sequence channel data marks what it wrote
+// here so outputs can skip ranges that have not changed since they last
+// looked.  The generation is bumped after the outputs have prepped a frame.
+extern DirtyRanges channelDataChanges;
+
 bool HasChannelOutputs();
 int InitializeChannelOutputs();
 int PrepareChannelData(char* channelData);
@@ -37,5 +43,8 @@ void ResetChannelOutputFrameNumber();
 void StartingOutput();
 void StoppingOutput();
 
+void GetChannelOutputTimingStats(Json::Value& result);
+void ResetChannelOutputTimingStats();
+
 const std::vector<std::pair<uint32_t, uint32_t>>& GetOutputRanges(bool precise = true);
 std::string GetOutputRangesAsString(bool precise = true, bool oneBased = false);
@@ -234,9 +234,6 @@ void DDPOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages& m
         } else {
             skippedFrames = 0;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 void DDPOutputData::DumpConfig() {
@@ -167,7 +167,6 @@ void E131OutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
         unsigned char* cur = channelData + startChannel - 1;
         int start = 0;
         bool anySkipped = false;
-        bool allSkipped = true;
         for (int x = 0; x < universeCount; x++) {
             if (NeedToOutputFrame(channelData, startChannel - 1, start, channelCount)) {
                 struct mmsghdr msg;
@@ -186,7 +185,6 @@ void E131OutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
 
                 ++e131Headers[x][E131_SEQUENCE_INDEX];
                 e131Iovecs[x * 2 + 1].iov_base = (void*)cur;
-                allSkipped = false;
             } else {
                 anySkipped = true;
             }
@@ -198,9 +196,6 @@ void E131OutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
         } else {
             skippedFrames = 0;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 
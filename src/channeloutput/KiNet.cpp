@@ -137,7 +137,6 @@ void KiNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
         msg.msg_hdr.msg_name = &kinetAddress;
         msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
         bool anySkipped = false;
-        bool allSkipped = true;
         for (int p = 0; p < portCount; p++) {
             bool nto = NeedToOutputFrame(channelData, startChannel - 1, start, kinetIovecs[p * 2 + 1].iov_len);
             if (nto) {
@@ -158,7 +157,6 @@ void KiNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
                 }
                 // set the pointer to the channelData for the universe
                 kinetIovecs[p * 2 + 1].iov_base = (void*)(&channelData[startChannel - 1 + start]);
-                allSkipped = false;
             } else {
                 anySkipped = true;
             }
@@ -169,9 +167,6 @@ void KiNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
         } else {
             skippedFrames = 0;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 void KiNetOutputData::DumpConfig() {
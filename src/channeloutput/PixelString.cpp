@@ -14,12 +14,18 @@
 
 #include "../Sequence.h"
 #include "../log.h"
+#include "../util/DirtyRanges.h"
 
+#include "ChannelOutputSetup.h"
 #include "PixelString.h"
 #include "../OutputMonitor.h"
 #include "../Warnings.h"
 #include "overlays/PixelOverlay.h"
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 
 #define MAX_PIXEL_STRING_LENGTH 1600
@@ -138,7 +144,11 @@ PixelString::PixelString(bool supportSmart) :
     m_outputChannels(0),
     m_isSmartReceiver(supportSmart),
     m_brightnessMaps(nullptr),
-    m_outputBuffer(nullptr) {
+    m_outputBuffer(nullptr),
+    m_sourceStart(0),
+    m_sourceCount(0),
+    m_lastPrepData(nullptr),
+    m_lastPrepGeneration(0) {
 }
 
 /*
@@ -290,6 +300,8 @@ int PixelString::Init(Json::Value config, Json::Value* pinConfig) {
 
     if (pinConfig && pinConfig->isMember("inverted") && (*pinConfig)["inverted"].asBool()) {
         invertOutput();
+    } else {
+        BuildOutputRuns();
     }
 
     return 1;
@@ -623,6 +635,72 @@ void PixelString::invertOutput() {
             vs.brightnessMap[x] = ~vs.brightnessMap[x];
         }
     }
+    BuildOutputRuns();
+}
+
+// shorter contiguous runs are left in with the mapped channels
+#define MIN_CONTIGUOUS_RUN 12
+
+void PixelString::BuildOutputRuns() {
+    m_outputRuns.clear();
+    int minSource = FPPD_MAX_CHANNELS;
+    int maxSource = -1;
+    int idx = 0;
+    for (auto& vs : m_virtualStrings) {
+        bool identity = true;
+        for (int x = 0; x < 256 && identity; x++) {
+            identity = vs.brightnessMap[x] == x;
+        }
+        const int* map = vs.chMap;
+        for (int x = 0; x < vs.chMapCount; x++) {
+            // the off/white channels never change
+            if (map[x] < FPPD_MAX_CHANNELS) {
+                minSource = std::min(minSource, map[x]);
+                maxSource = std::max(maxSource, map[x]);
+            }
+        }
+        int ch = 0;
+        while (ch < vs.chMapCount) {
+            int len = 1;
+            while ((ch + len) < vs.chMapCount && map[ch + len] == (map[ch] + len)) {
+                len++;
+            }
+            if (len >= MIN_CONTIGUOUS_RUN) {
+                m_outputRuns.push_back({ idx + ch, len, map[ch], nullptr, vs.brightnessMap, identity, { -1, -1, -1 } });
+                ch += len;
+                continue;
+            }
+            if ((ch + MIN_CONTIGUOUS_RUN) <= vs.chMapCount) {
+                // contiguous pixels, but the color order is changed (GRB, etc...)
+                int base = std::min(map[ch], std::min(map[ch + 1], map[ch + 2]));
+                int8_t order[3] = { (int8_t)(map[ch] - base), (int8_t)(map[ch + 1] - base), (int8_t)(map[ch + 2] - base) };
+                if (order[0] < 3 && order[1] < 3 && order[2] < 3 && order[0] != order[1] && order[0] != order[2] && order[1] != order[2]) {
+                    int plen = 0;
+                    while ((ch + plen + 3) <= vs.chMapCount &&
+                           map[ch + plen] == (base + plen + order[0]) &&
+                           map[ch + plen + 1] == (base + plen + order[1]) &&
+                           map[ch + plen + 2] == (base + plen + order[2])) {
+                        plen += 3;
+                    }
+                    if (plen >= MIN_CONTIGUOUS_RUN) {
+                        m_outputRuns.push_back({ idx + ch, plen, base, nullptr, vs.brightnessMap, identity, { order[0], order[1], order[2] } });
+                        ch += plen;
+                        continue;
+                    }
+                }
+            }
+            if (!m_outputRuns.empty() && m_outputRuns.back().source == -1 && (m_outputRuns.back().outputOffset + m_outputRuns.back().count) == (idx + ch) && m_outputRuns.back().brightness == vs.brightnessMap) {
+                m_outputRuns.back().count += len;
+            } else {
+                m_outputRuns.push_back({ idx + ch, len, -1, &map[ch], vs.brightnessMap, identity, { -1, -1, -1 } });
+            }
+            ch += len;
+        }
+        idx += vs.chMapCount;
+    }
+    m_sourceStart = minSource;
+    m_sourceCount = maxSource >= minSource ? maxSource - minSource + 1 : 0;
+    m_lastPrepData = nullptr;
 }
 
 void PixelString::AutoCreateOverlayModels(const std::vector<PixelString*>& strings, std::list<std::string>& autoModelNames) {
@@ -705,13 +783,104 @@ void PixelString::AutoCreateOverlayModels(const std::vector<PixelString*>& strin
     }
 }
 
+static inline void LookupBlock(uint8_t* out, const uint8_t* in, int count, const uint8_t* table) {
+    int x = 0;
+#if defined(__aarch64__)
+    // 256 entry table lookup done as four 64 byte table lookups,
+    // indexes out of range of each table are left alone by vqtbx4q
+    const uint8x16x4_t t0 = { vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48) };
+    const uint8x16x4_t t1 = { vld1q_u8(table + 64), vld1q_u8(table + 80), vld1q_u8(table + 96), vld1q_u8(table + 112) };
+    const uint8x16x4_t t2 = { vld1q_u8(table + 128), vld1q_u8(table + 144), vld1q_u8(table + 160), vld1q_u8(table + 176) };
+    const uint8x16x4_t t3 = { vld1q_u8(table + 192), vld1q_u8(table + 208), vld1q_u8(table + 224), vld1q_u8(table + 240) };
+    const uint8x16_t s64 = vdupq_n_u8(64);
+    for (; x + 16 <= count; x += 16) {
+        uint8x16_t idx = vld1q_u8(in + x);
+        uint8x16_t r = vqtbl4q_u8(t0, idx);
+        idx = vsubq_u8(idx, s64);
+        r = vqtbx4q_u8(r, t1, idx);
+        idx = vsubq_u8(idx, s64);
+        r = vqtbx4q_u8(r, t2, idx);
+        idx = vsubq_u8(idx, s64);
+        r = vqtbx4q_u8(r, t3, idx);
+        vst1q_u8(out + x, r);
+    }
+#else
+    for (; x + 4 <= count; x += 4) {
+        uint8_t a = table[in[x]];
+        uint8_t b = table[in[x + 1]];
+        uint8_t c = table[in[x + 2]];
+        uint8_t d = table[in[x + 3]];
+        out[x] = a;
+        out[x + 1] = b;
+        out[x + 2] = c;
+        out[x + 3] = d;
+    }
+#endif
+    for (; x < count; x++) {
+        out[x] = table[in[x]];
+    }
+}
+
+static inline void ReorderBlock(uint8_t* out, const uint8_t* in, int count, const int8_t* order, const uint8_t* table) {
+    int x = 0;
+#if defined(__aarch64__)
+    const uint8x16x4_t t0 = { vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48) };
+    const uint8x16x4_t t1 = { vld1q_u8(table + 64), vld1q_u8(table + 80), vld1q_u8(table + 96), vld1q_u8(table + 112) };
+    const uint8x16x4_t t2 = { vld1q_u8(table + 128), vld1q_u8(table + 144), vld1q_u8(table + 160), vld1q_u8(table + 176) };
+    const uint8x16x4_t t3 = { vld1q_u8(table + 192), vld1q_u8(table + 208), vld1q_u8(table + 224), vld1q_u8(table + 240) };
+    const uint8x16_t s64 = vdupq_n_u8(64);
+    for (; x + 48 <= count; x += 48) {
+        // de-interleave 16 pixels, swap the planes around and look them up
+        uint8x16x3_t px = vld3q_u8(in + x);
+        uint8x16x3_t res;
+        for (int c = 0; c < 3; c++) {
+            uint8x16_t idx = px.val[order[c]];
+            uint8x16_t r = vqtbl4q_u8(t0, idx);
+            idx = vsubq_u8(idx, s64);
+            r = vqtbx4q_u8(r, t1, idx);
+            idx = vsubq_u8(idx, s64);
+            r = vqtbx4q_u8(r, t2, idx);
+            idx = vsubq_u8(idx, s64);
+            r = vqtbx4q_u8(r, t3, idx);
+            res.val[c] = r;
+        }
+        vst3q_u8(out + x, res);
+    }
+#endif
+    const int o0 = order[0];
+    const int o1 = order[1];
+    const int o2 = order[2];
+    for (; x < count; x += 3) {
+        uint8_t a = table[in[x + o0]];
+        uint8_t b = table[in[x + o1]];
+        uint8_t c = table[in[x + o2]];
+        out[x] = a;
+        out[x + 1] = b;
+        out[x + 2] = c;
+    }
+}
+
 uint8_t* PixelString::prepareOutput(uint8_t* channelData) {
-    int idx = 0;
-    for (auto& vs : m_virtualStrings) {
-        int* map = vs.chMap;
-        uint8_t* brightness = vs.brightnessMap;
-        for (int ch = 0; ch < vs.chMapCount; ch++) {
-            m_outputBuffer[idx++] = brightness[channelData[map[ch]]];
+    uint64_t generation = channelDataChanges.getGeneration();
+    if (channelData == m_lastPrepData && !channelDataChanges.isDirty(m_sourceStart, m_sourceCount, m_lastPrepGeneration)) {
+        return m_outputBuffer;
+    }
+    m_lastPrepData = channelData;
+    m_lastPrepGeneration = generation;
+    for (auto& r : m_outputRuns) {
+        uint8_t* out = m_outputBuffer + r.outputOffset;
+        if (r.source == -1) {
+            const int* map = r.map;
+            const uint8_t* brightness = r.brightness;
+            for (int ch = 0; ch < r.count; ch++) {
+                out[ch] = brightness[channelData[map[ch]]];
+            }
+        } else if (r.order[0] != -1) {
+            ReorderBlock(out, channelData + r.source, r.count, r.order, r.brightness);
+        } else if (r.identity) {
+            memcpy(out, channelData + r.source, r.count);
+        } else {
+            LookupBlock(out, channelData + r.source, r.count, r.brightness);
         }
     }
     return m_outputBuffer;
@@ -101,8 +101,34 @@ public:
 
     // returned buffer is owned by the PixelString and reused next frame
     uint8_t* prepareOutput(uint8_t* channelData);
+    // m_outputBuffer was filled by something else (testers), the next
+    // prepareOutput needs to rebuild all of it
+    void outputBufferModified() { m_lastPrepData = nullptr; }
 
 private:
+    // m_outputMap broken up into runs so prepareOutput can handle channels
+    // that are contiguous in the channel data as a block instead of going
+    // through the map one channel at a time
+    class OutputRun {
+    public:
+        int outputOffset;
+        int count;
+        int source; // first source channel, -1 if not contiguous
+        const int* map;
+        const uint8_t* brightness;
+        bool identity; // brightness map doesn't change anything
+        int8_t order[3]; // for contiguous 3 channel pixels in a different color order, else order[0] is -1
+    };
+    std::vector<OutputRun> m_outputRuns;
+    void BuildOutputRuns();
+
+    // range of channel data the runs read from, if nothing in it has been
+    // written since the last prepareOutput then m_outputBuffer is still good
+    int m_sourceStart;
+    int m_sourceCount;
+    uint8_t* m_lastPrepData;
+    uint64_t m_lastPrepGeneration;
+
     void SetupMap(int vsOffset, const VirtualString& vs);
     void FlipPixels(int offset1, int offset2, int chanCount);
     void DumpMap(const char* msg);
@@ -113,7 +113,6 @@ void TwinklyOutputData::PrepareData(unsigned char* channelData, UDPOutputMessage
         msg.msg_hdr.msg_name = &twinklyAddress;
         msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
         bool anySkipped = false;
-        bool allSkipped = true;
         for (int p = 0; p < portCount; p++) {
             bool nto = NeedToOutputFrame(channelData, startChannel - 1, start, twinklyIovecs[p * 2 + 1].iov_len);
             if (nto) {
@@ -125,7 +124,6 @@ void TwinklyOutputData::PrepareData(unsigned char* channelData, UDPOutputMessage
 
                 // set the pointer to the channelData for the universe
                 twinklyIovecs[p * 2 + 1].iov_base = (void*)(&channelData[startChannel - 1 + start]);
-                allSkipped = false;
             } else {
                 anySkipped = true;
             }
@@ -136,9 +134,6 @@ void TwinklyOutputData::PrepareData(unsigned char* channelData, UDPOutputMessage
         } else {
             skippedFrames = 0;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 
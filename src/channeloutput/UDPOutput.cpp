@@ -18,6 +18,9 @@
 #include <ifaddrs.h>
 #include <netdb.h>
 #include <unistd.h>
+#ifndef PLATFORM_OSX
+#include <netinet/udp.h>
+#endif
 
 #include <curl/curl.h>
 #include <set>
@@ -27,7 +30,10 @@
 #include "../common.h"
 #include "../log.h"
 #include "../settings.h"
+#include "../util/DirtyRanges.h"
+#include "../util/TimingStats.h"
 
+#include "ChannelOutputSetup.h"
 #include "UDPOutput.h"
 #include "ping.h"
 
@@ -44,6 +50,13 @@
 
 constexpr int UDP_PING_TIMEOUT = 250;
 
+#if defined(UDP_SEGMENT) && !defined(PLATFORM_OSX)
+#define HAS_UDP_SEGMENT
+// kernel limits for a single UDP_SEGMENT send
+constexpr int UDP_MAX_GSO_SEGMENTS = 64;
+constexpr int UDP_MAX_GSO_BYTES = 65000;
+#endif
+
 class UDPPlugin : public FPPPlugins::Plugin, public FPPPlugins::ChannelOutputPlugin {
 public:
     UDPPlugin() :
@@ -79,9 +92,21 @@ public:
     std::vector<int> sockets;
     int errCount;
     int curSocket;
+
+    TimingStats sendTimes;
+    std::atomic<uint64_t> messageCount = 0;
+    std::atomic<uint64_t> retryCount = 0; // EAGAIN/partial sends that had to be retried
+    std::atomic<uint64_t> failedCount = 0;
+    std::atomic<uint64_t> segmentedCount = 0; // messages sent as part of a UDP_SEGMENT send
+
+    // set if the route/NIC for this destination can't do UDP_SEGMENT
+    std::atomic_bool segmentationFailed = false;
+    std::vector<struct iovec> segmentIovecs;
 };
 
-UDPOutputMessages::UDPOutputMessages() {
+UDPOutputMessages::UDPOutputMessages() :
+    lastKey(0),
+    lastMessages(nullptr) {
 }
 UDPOutputMessages::~UDPOutputMessages() {
     for (auto& si : sendSockets) {
@@ -109,7 +134,11 @@ void UDPOutputMessages::ForceSocket(unsigned int key, int socket) {
     info->sockets.push_back(socket);
 }
 std::vector<struct mmsghdr>& UDPOutputMessages::GetMessages(unsigned int key) {
-    return messages[key];
+    if (lastMessages == nullptr || key != lastKey) {
+        lastMessages = &messages[key];
+        lastKey = key;
+    }
+    return *lastMessages;
 }
 void UDPOutputMessages::clearMessages() {
     for (auto& m : messages) {
@@ -130,7 +159,11 @@ UDPOutputData::UDPOutputData(const Json::Value& config) :
     type(0),
     monitor(true),
     failCount(0),
+    prepGeneration(0),
+    packetCount(0),
+    duplicateCount(0),
     lastData(nullptr),
+    lastDataSize(0),
     skippedFrames(0) {
     if (config.isMember("description")) {
         description = config["description"].asString();
@@ -188,64 +221,88 @@ in_addr_t UDPOutputData::toInetAddr(const std::string& ipAddress, bool& valid) {
     return inet_addr(ipAddress.c_str());
 }
 
-void UDPOutputData::SaveFrame(unsigned char* channelData, int len) {
-    if (deDuplicate) {
-        if (lastData == nullptr) {
-            lastData = (unsigned char*)calloc(1, len);
+// Compares the new data to the saved copy a word at a time.  Once a
+// difference is found the rest of the range is copied into the saved copy
+// so the data is only walked once.  Returns true if anything changed.
+static bool CompareAndStore(unsigned char* saved, const unsigned char* data, int count) {
+    int x = 0;
+    for (; (x + 32) <= count; x += 32) {
+        uint64_t a[4], b[4];
+        memcpy(a, data + x, 32);
+        memcpy(b, saved + x, 32);
+        if ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3])) {
+            memcpy(saved + x, data + x, count - x);
+            return true;
         }
-        /*
-        printf("Saving: %d   %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", len,
-               channelData[0], channelData[1], channelData[2], channelData[3], channelData[4], channelData[5],
-               channelData[6], channelData[7], channelData[8], channelData[9], channelData[10], channelData[11]);
-         */
-        memcpy(lastData, channelData, len);
     }
+    for (; (x + 8) <= count; x += 8) {
+        uint64_t a, b;
+        memcpy(&a, data + x, 8);
+        memcpy(&b, saved + x, 8);
+        if (a != b) {
+            memcpy(saved + x, data + x, count - x);
+            return true;
+        }
+    }
+    for (; x < count; x++) {
+        if (data[x] != saved[x]) {
+            memcpy(saved + x, data + x, count - x);
+            return true;
+        }
+    }
+    return false;
 }
 
 bool UDPOutputData::NeedToOutputFrame(unsigned char* channelData, int startChannel, int savedIdx, int count) {
-    if (deDuplicate && skippedFrames < 10) {
-        if (lastData == nullptr) {
-            return true;
-        }
-        for (int x = 0; x < count; x++) {
-            if (channelData[x + savedIdx + startChannel] != lastData[x + savedIdx]) {
-                /*
-                printf("ND: %d   %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", x,
-                       lastData[0], lastData[1], lastData[2], lastData[3], lastData[4], lastData[5],
-                       lastData[6], lastData[7], lastData[8], lastData[9], lastData[10], lastData[11]);
-                printf("%d %d    %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", start, startChannel, x,
-                       channelData[start + startChannel + 0], channelData[start + startChannel + 1], channelData[start + startChannel + 2],
-                       channelData[start + startChannel + 3], channelData[start + startChannel + 4], channelData[start + startChannel + 5],
-                       channelData[start + startChannel + 6], channelData[start + startChannel + 7], channelData[start + startChannel + 8],
-                       channelData[start + startChannel + 9], channelData[start + startChannel + 10], channelData[start + startChannel + 11]);
-                 printf("New data %d  %d  %d      %X %X\n", x, startChannel, savedIdx, channelData[x + savedIdx + startChannel], lastData[x + savedIdx]);
-                 */
-                return true;
-            }
+    if (!deDuplicate) {
+        packetCount++;
+        return true;
+    }
+    unsigned char* data = channelData + startChannel + savedIdx;
+    bool changed = true;
+    if ((savedIdx + count) > lastDataSize) {
+        int newSize = std::max(channelCount, savedIdx + count);
+        unsigned char* newData = (unsigned char*)calloc(1, newSize);
+        if (lastData) {
+            memcpy(newData, lastData, lastDataSize);
+            free(lastData);
         }
-        return false;
+        lastData = newData;
+        lastDataSize = newSize;
+        memcpy(lastData + savedIdx, data, count);
+    } else if (!channelDataChanges.isDirty(startChannel + savedIdx, count, prepGeneration)) {
+        // nothing has written to this range since lastData was saved
+        changed = false;
+    } else {
+        changed = CompareAndStore(lastData + savedIdx, data, count);
     }
-    return true;
+    // resend everything every so often even if nothing changed
+    if (changed || skippedFrames >= 10) {
+        packetCount++;
+        return true;
+    }
+    duplicateCount++;
+    return false;
 }
 
 UDPOutput::UDPOutput(unsigned int startChannel, unsigned int channelCount) :
+    lastPrepData(nullptr),
     networkCallbackId(0),
+    workGeneration(0),
+    nextWorkItem(0),
     doneWorkCount(0),
-    numWorkThreads(0),
+    activeWorkThreads(0),
     runWorkThreads(true),
     useThreadedOutput(true),
-    blockingOutput(false) {
+    blockingOutput(false),
+    useSegmentation(false) {
     INSTANCE = this;
 }
 UDPOutput::~UDPOutput() {
-    runWorkThreads = false;
-    workSignal.notify_all();
+    StopWorkThreads();
 
     INSTANCE = nullptr;
     NetworkMonitor::INSTANCE.removeCallback(networkCallbackId);
-    while (numWorkThreads) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
     // Need to make sure all curls are processed before we delete the outputs
     // or we may have curl callbacks trying to access deleted data.
     while (CurlManager::INSTANCE.processCurls()) {
@@ -337,6 +394,9 @@ int UDPOutput::Init(Json::Value config) {
     }
 
     bool disableFakeBridges = getSettingInt("DisableFakeNetworkBridges");
+#ifdef HAS_UDP_SEGMENT
+    useSegmentation = !blockingOutput && getSettingInt("UDPSegmentationOffload", 0);
+#endif
 
     for (auto o : outputs) {
         if (o->IsPingable() && o->active) {
@@ -413,8 +473,14 @@ int UDPOutput::Init(Json::Value config) {
 }
 int UDPOutput::Close() {
     NetworkMonitor::INSTANCE.removeCallback(networkCallbackId);
+    std::unique_lock<std::mutex> lk(socketMutex);
+    // the messages and sockets can't go away while a send thread is still using them
+    while (!WaitForWorkThreads(100)) {
+        LogWarn(VB_CHANNELOUT, "Waiting for UDP send threads to finish\n");
+    }
     messages.clearMessages();
     messages.clearSockets();
+    lk.unlock();
     for (auto o : outputs) {
         if (o->IsPingable() && o->Monitor()) {
             PingManager::INSTANCE.removePeriodicPing(o->ipAddress);
@@ -425,12 +491,25 @@ int UDPOutput::Close() {
 void UDPOutput::PrepData(unsigned char* channelData) {
     if (enabled) {
         std::unique_lock<std::mutex> lk(socketMutex);
+        // a slow send from last frame could still be using the messages,
+        // leave them alone and skip this frame
+        if (!WaitForWorkThreads(100)) {
+            LogWarn(VB_CHANNELOUT, "UDP send threads still busy with the previous frame, not preparing new data\n");
+            return;
+        }
         messages.clearMessages();
+        uint64_t generation = channelDataChanges.getGeneration();
         for (auto a : outputs) {
+            if (channelData != lastPrepData) {
+                // different buffer, the dirty ranges don't apply
+                a->prepGeneration = 0;
+            }
             if (a->valid && a->active) {
                 a->PrepareData(channelData, messages);
+                a->prepGeneration = generation;
             }
         }
+        lastPrepData = channelData;
         // add any sync packets or whatever that are needed
         for (auto a : outputs) {
             if (a->valid && a->active) {
@@ -451,10 +530,174 @@ void UDPOutput::GetRequiredChannelRanges(const std::function<void(int, int)>& ad
     }
 }
 
+static std::string SocketKeyName(unsigned int key, const std::string& ip) {
+    switch (key) {
+    case MULTICAST_MESSAGES_KEY:
+    case LATE_MULTICAST_MESSAGES_KEY:
+        return "multicast";
+    case BROADCAST_MESSAGES_KEY:
+        return "broadcast";
+    case ANY_MESSAGES_KEY:
+        return "any";
+    default:
+        return ip;
+    }
+}
+
+void UDPOutput::GetStats(Json::Value& result) {
+    std::unique_lock<std::mutex> lk(socketMutex);
+    for (auto& si : messages.sendSockets) {
+        Json::Value v;
+        v["key"] = si.first;
+        v["address"] = SocketKeyName(si.first, HexToIP(si.first));
+        v["sockets"] = (int)si.second->sockets.size();
+        v["messages"] = (Json::UInt64)si.second->messageCount.load();
+        v["retries"] = (Json::UInt64)si.second->retryCount.load();
+        v["failed"] = (Json::UInt64)si.second->failedCount.load();
+        v["segmented"] = (Json::UInt64)si.second->segmentedCount.load();
+        si.second->sendTimes.toJson(v["sendTime"]);
+        result["destinations"].append(v);
+    }
+    lk.unlock();
+    for (auto a : outputs) {
+        Json::Value v;
+        v["type"] = a->GetOutputTypeString();
+        v["description"] = a->description;
+        v["address"] = a->ipAddress;
+        v["startChannel"] = a->startChannel;
+        v["channelCount"] = a->channelCount;
+        v["active"] = a->active;
+        v["packets"] = (Json::UInt64)a->packetCount.load();
+        v["duplicates"] = (Json::UInt64)a->duplicateCount.load();
+        result["outputs"].append(v);
+    }
+}
+void UDPOutput::ResetStats() {
+    std::unique_lock<std::mutex> lk(socketMutex);
+    for (auto& si : messages.sendSockets) {
+        si.second->messageCount = 0;
+        si.second->retryCount = 0;
+        si.second->failedCount = 0;
+        si.second->segmentedCount = 0;
+        si.second->sendTimes.reset();
+    }
+    lk.unlock();
+    for (auto a : outputs) {
+        a->packetCount = 0;
+        a->duplicateCount = 0;
+    }
+}
+
 void UDPOutput::addOutput(UDPOutputData* out) {
     outputs.push_back(out);
 }
 int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs) {
+    uint64_t startTime = GetTimeMicros();
+    int outputCount = TrySendMessages(socketKey, socketInfo, sendmsgs);
+    socketInfo->sendTimes.addSample(GetTimeMicros() - startTime);
+    socketInfo->messageCount += outputCount;
+    if (outputCount != sendmsgs.size()) {
+        socketInfo->failedCount += sendmsgs.size() - outputCount;
+    }
+    return outputCount;
+}
+static inline size_t MessageSize(const struct msghdr& m) {
+    size_t s = 0;
+    for (int x = 0; x < m.msg_iovlen; x++) {
+        s += m.msg_iov[x].iov_len;
+    }
+    return s;
+}
+// b can follow a in a segmented send
+static inline bool CanSegment(const struct msghdr& a, const struct msghdr& b) {
+    return a.msg_namelen == b.msg_namelen && a.msg_controllen == 0 && b.msg_controllen == 0 &&
+           MessageSize(b) <= MessageSize(a) &&
+           (a.msg_name == b.msg_name || memcmp(a.msg_name, b.msg_name, a.msg_namelen) == 0);
+}
+
+int UDPOutput::SendSegmented(int sendSocket, SendSocketInfo* socketInfo, struct mmsghdr* msgs, int msgCount) {
+#ifdef HAS_UDP_SEGMENT
+    int outputCount = 0;
+    int x = 0;
+    while (x < msgCount) {
+        // find the run of messages that can go out as one send, all
+        // segments must be the same size except the last which can be shorter
+        size_t segSize = MessageSize(msgs[x].msg_hdr);
+        size_t total = segSize;
+        int iovCount = msgs[x].msg_hdr.msg_iovlen;
+        int end = x + 1;
+        while (end < msgCount && (end - x) < UDP_MAX_GSO_SEGMENTS) {
+            const struct msghdr& m = msgs[end].msg_hdr;
+            size_t sz = MessageSize(m);
+            if ((total + sz) > UDP_MAX_GSO_BYTES || (iovCount + m.msg_iovlen) > IOV_MAX || !CanSegment(msgs[x].msg_hdr, m)) {
+                break;
+            }
+            total += sz;
+            iovCount += m.msg_iovlen;
+            ++end;
+            if (sz < segSize) {
+                break;
+            }
+        }
+        if (end - x < 2) {
+            // nothing to combine, send everything up to the next run with sendmmsg
+            int single = x + 1;
+            while (single + 1 < msgCount && !CanSegment(msgs[single].msg_hdr, msgs[single + 1].msg_hdr)) {
+                ++single;
+            }
+            if (single + 1 >= msgCount) {
+                single = msgCount;
+            }
+            int oc = sendmmsg(sendSocket, &msgs[x], single - x, MSG_DONTWAIT);
+            if (oc <= 0) {
+                return outputCount;
+            }
+            outputCount += oc;
+            if (oc != single - x) {
+                return outputCount;
+            }
+            x = single;
+            continue;
+        }
+
+        socketInfo->segmentIovecs.clear();
+        for (int m = x; m < end; m++) {
+            socketInfo->segmentIovecs.insert(socketInfo->segmentIovecs.end(), msgs[m].msg_hdr.msg_iov, msgs[m].msg_hdr.msg_iov + msgs[m].msg_hdr.msg_iovlen);
+        }
+        char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+        struct msghdr hdr = msgs[x].msg_hdr;
+        hdr.msg_iov = &socketInfo->segmentIovecs[0];
+        hdr.msg_iovlen = socketInfo->segmentIovecs.size();
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof(control);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        *((uint16_t*)CMSG_DATA(cm)) = segSize;
+
+        if (sendmsg(sendSocket, &hdr, MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                return outputCount;
+            }
+            // EIO (no checksum offload), EINVAL, ENOPROTOOPT, etc... just
+            // stop trying for this destination and let sendmmsg handle it
+            LogInfo(VB_CHANNELOUT, "UDP_SEGMENT send failed (%d - %s), using sendmmsg for this destination\n", errno, strerror(errno));
+            socketInfo->segmentationFailed = true;
+            int oc = sendmmsg(sendSocket, &msgs[x], msgCount - x, MSG_DONTWAIT);
+            return outputCount + (oc > 0 ? oc : 0);
+        }
+        socketInfo->segmentedCount += end - x;
+        outputCount += end - x;
+        x = end;
+    }
+    return outputCount;
+#else
+    return sendmmsg(sendSocket, msgs, msgCount, MSG_DONTWAIT);
+#endif
+}
+
+int UDPOutput::TrySendMessages(unsigned int socketKey, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs) {
     errno = 0;
     struct mmsghdr* msgs = &sendmsgs[0];
     int msgCount = sendmsgs.size();
@@ -481,17 +724,24 @@ int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo,
                 // didn't send, we'll yield once and re-send
                 --x;
                 ++errorCount;
+                ++socketInfo->retryCount;
                 std::this_thread::yield();
             }
         }
     } else {
-        int oc = sendmmsg(sendSocket, msgs, msgCount, MSG_DONTWAIT);
+        int oc;
+        if (useSegmentation && !socketInfo->segmentationFailed) {
+            oc = SendSegmented(sendSocket, socketInfo, msgs, msgCount);
+        } else {
+            oc = sendmmsg(sendSocket, msgs, msgCount, MSG_DONTWAIT);
+        }
         if (oc > 0) {
             outputCount += oc;
         }
         if (outputCount != msgCount) {
             // in many cases, a simple thread yield will allow the network stack
             // to flush some data and free up space, give that a chance first
+            ++socketInfo->retryCount;
             std::this_thread::sleep_for(std::chrono::microseconds(100));
             oc = sendmmsg(sendSocket, &msgs[outputCount], msgCount - outputCount, MSG_DONTWAIT);
             while (oc > 0) {
@@ -537,6 +787,7 @@ int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo,
             return outputCount;
         }
         errno = 0;
+        ++socketInfo->retryCount;
         int oc = sendmmsg(sendSocket, &msgs[outputCount], msgCount - outputCount, MSG_DONTWAIT);
         while (oc > 0) {
             outputCount += oc;
@@ -552,41 +803,108 @@ static void DoWorkThread(UDPOutput* output) {
     output->BackgroundOutputWork();
 }
 
-void UDPOutput::BackgroundOutputWork() {
-    std::chrono::high_resolution_clock clock;
-    while (runWorkThreads) {
-        std::unique_lock<std::mutex> lock(workMutex);
-        if (workQueue.empty()) {
-            workSignal.wait(lock);
+void UDPOutput::StartWorkThreads() {
+    int count = std::clamp((int)std::thread::hardware_concurrency() - 1, 2, 4);
+    runWorkThreads = true;
+    for (int x = 0; x < count; x++) {
+        workThreads.emplace_back(DoWorkThread, this);
+    }
+#ifndef PLATFORM_OSX
+    // this is called from the output thread so keep the sends off its CPU
+    int cpus = std::thread::hardware_concurrency();
+    int outputCPU = sched_getcpu();
+    if (cpus > 2 && outputCPU >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < cpus; c++) {
+            if (c != outputCPU) {
+                CPU_SET(c, &set);
+            }
+        }
+        for (auto& t : workThreads) {
+            pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
         }
-        if (!workQueue.empty()) {
-            WorkItem i = workQueue.front();
-            workQueue.pop_front();
-            lock.unlock();
+    }
+    LogDebug(VB_CHANNELOUT, "Started %d UDP send threads, output thread on CPU %d\n", count, outputCPU);
+#endif
+}
 
-            auto t1 = clock.now();
-            int outputCount = SendMessages(i.id, i.socketInfo, i.msgs);
-            auto t2 = clock.now();
+void UDPOutput::StopWorkThreads() {
+    std::unique_lock<std::mutex> lock(workMutex);
+    runWorkThreads = false;
+    lock.unlock();
+    workSignal.notify_all();
+    for (auto& t : workThreads) {
+        t.join();
+    }
+    workThreads.clear();
+}
 
-            long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-            if ((outputCount != i.msgs.size()) || (diff > 100)) {
-                i.socketInfo->errCount++;
+// must be called with the socketMutex held
+bool UDPOutput::WaitForWorkThreads(int ms) {
+    std::unique_lock<std::mutex> lock(workMutex);
+    // nothing new can be picked up, then wait for anything in progress
+    nextWorkItem = workItems.size();
+    return workDoneSignal.wait_for(lock, std::chrono::milliseconds(ms), [this]() {
+        return activeWorkThreads == 0;
+    });
+}
 
-                // failed to send all messages or it took more than 100ms to send them
-                LogErr(VB_CHANNELOUT, "%s() failed for UDP output (IP: %s   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
-                       blockingOutput ? "sendmsg" : "sendmmsg", HexToIP(i.id).c_str(),
-                       outputCount, i.msgs.size(), diff, i.socketInfo->errCount,
-                       errno,
-                       strerror(errno));
-            } else {
-                i.socketInfo->errCount = 0;
-            }
+void UDPOutput::SendWorkItem(const WorkItem& i) {
+    std::chrono::high_resolution_clock clock;
+    auto t1 = clock.now();
+    int outputCount = SendMessages(i.id, i.socketInfo, *i.msgs);
+    auto t2 = clock.now();
+
+    long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+    if ((outputCount != i.msgs->size()) || (diff > 100)) {
+        i.socketInfo->errCount++;
+
+        // failed to send all messages or it took more than 100ms to send them
+        LogErr(VB_CHANNELOUT, "%s() failed for UDP output (IP: %s   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
+               blockingOutput ? "sendmsg" : "sendmmsg", HexToIP(i.id).c_str(),
+               outputCount, i.msgs->size(), diff, i.socketInfo->errCount,
+               errno,
+               strerror(errno));
+    } else {
+        i.socketInfo->errCount = 0;
+    }
+}
 
-            doneWorkCount++;
+void UDPOutput::DoWorkItems() {
+    int count = workItems.size();
+    int idx = nextWorkItem++;
+    while (idx < count) {
+        SendWorkItem(workItems[idx]);
+        if (++doneWorkCount == count) {
+            std::unique_lock<std::mutex> lock(workMutex);
+            workDoneSignal.notify_all();
         }
+        idx = nextWorkItem++;
     }
+}
 
-    --numWorkThreads;
+void UDPOutput::BackgroundOutputWork() {
+    uint32_t lastGeneration = 0;
+    std::unique_lock<std::mutex> lock(workMutex);
+    while (true) {
+        workSignal.wait(lock, [this, &lastGeneration]() {
+            return !runWorkThreads || workGeneration != lastGeneration;
+        });
+        if (!runWorkThreads) {
+            break;
+        }
+        lastGeneration = workGeneration;
+        ++activeWorkThreads;
+        lock.unlock();
+
+        DoWorkItems();
+
+        lock.lock();
+        if (--activeWorkThreads == 0) {
+            workDoneSignal.notify_all();
+        }
+    }
 }
 
 int UDPOutput::SendData(unsigned char* channelData) {
@@ -596,34 +914,38 @@ int UDPOutput::SendData(unsigned char* channelData) {
     }
     std::chrono::high_resolution_clock clock;
     if (useThreadedOutput) {
-        doneWorkCount = 0;
-        int total = 0;
-        auto t1 = clock.now();
+        if (workThreads.empty()) {
+            StartWorkThreads();
+        }
+        if (!WaitForWorkThreads(50)) {
+            LogWarn(VB_CHANNELOUT, "UDP send threads still busy with the previous frame\n");
+            return 0;
+        }
+        std::unique_lock<std::mutex> lock(workMutex);
+        workItems.clear();
         for (auto& msgs : messages.messages) {
             if (!msgs.second.empty() && msgs.first < LATE_MULTICAST_MESSAGES_KEY) {
                 SendSocketInfo* socketInfo = findOrCreateSocket(msgs.first);
-
-                std::unique_lock<std::mutex> lock(workMutex);
-                workQueue.push_back(WorkItem(msgs.first, socketInfo, msgs.second));
-                lock.unlock();
-                workSignal.notify_one();
-                ++total;
+                workItems.push_back({ msgs.first, socketInfo, &msgs.second });
             }
         }
-        std::unique_lock<std::mutex> lock(workMutex);
-        while (numWorkThreads < workQueue.size()) {
-            std::thread(DoWorkThread, this).detach();
-            numWorkThreads++;
-        }
-        if (workQueue.size()) {
-            workSignal.notify_all();
-        }
+        int total = workItems.size();
+        doneWorkCount = 0;
+        nextWorkItem = 0;
+        ++workGeneration;
         lock.unlock();
-        auto t2 = clock.now();
-        while (doneWorkCount != total && std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() < 50) {
-            std::this_thread::sleep_for(std::chrono::microseconds(250));
-            t2 = clock.now();
-        }
+        workSignal.notify_all();
+
+        // help out rather than just wait
+        DoWorkItems();
+
+        lock.lock();
+        workDoneSignal.wait_for(lock, std::chrono::milliseconds(50), [this, total]() {
+            return doneWorkCount == total;
+        });
+        lock.unlock();
+        auto t1 = clock.now();
+        auto t2 = t1;
         if (doneWorkCount == total) {
             // now output the LATE/Broadcast packets (likely sync packets)
             for (auto& msgs : messages.messages) {
@@ -752,6 +1074,7 @@ void UDPOutput::DumpConfig() {
     LogDebug(VB_CHANNELOUT, "    Interface        : %s\n", outInterface.c_str());
     LogDebug(VB_CHANNELOUT, "    Threaded         : %d\n", useThreadedOutput);
     LogDebug(VB_CHANNELOUT, "    Blocking         : %d\n", blockingOutput);
+    LogDebug(VB_CHANNELOUT, "    Segmentation     : %d\n", useSegmentation);
     LogDebug(VB_CHANNELOUT, "    Needs Broadcast  : %d\n", needsBroadcast);
     for (auto u : outputs) {
         u->DumpConfig();
@@ -760,6 +1083,9 @@ void UDPOutput::DumpConfig() {
 
 void UDPOutput::CloseNetwork() {
     std::unique_lock<std::mutex> lk(socketMutex);
+    while (!WaitForWorkThreads(100)) {
+        LogWarn(VB_CHANNELOUT, "Waiting for UDP send threads to finish\n");
+    }
     messages.clearSockets();
     lk.unlock();
     PingControllers(false);
@@ -856,6 +1182,11 @@ bool UDPOutput::InitNetwork() {
     localAddress.sin_addr.s_addr = inet_addr("127.0.0.1");
 
     if (!messages.sendSockets.empty()) {
+        // outputs reconfigured or the interface came back, the route/NIC
+        // may be able to do UDP_SEGMENT now
+        for (auto& si : messages.sendSockets) {
+            si.second->segmentationFailed = false;
+        }
         return true;
     }
 
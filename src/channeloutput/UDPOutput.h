@@ -46,9 +46,15 @@ public:
     std::vector<struct mmsghdr>& operator[](unsigned int key) { return GetMessages(key); }
 
 private:
+    // The vectors are cleared, not removed, each frame so they keep their
+    // capacity and the messages are built without allocating.
     std::map<unsigned int, std::vector<struct mmsghdr>> messages;
     std::map<unsigned int, SendSocketInfo*> sendSockets;
 
+    // outputs add all their messages for one destination in a row
+    unsigned int lastKey;
+    std::vector<struct mmsghdr>* lastMessages;
+
     void clearMessages();
     void clearSockets();
 
@@ -90,15 +96,26 @@ public:
 
     int failCount;
 
+    // channelDataChanges generation when PrepareData was last called, if
+    // nothing in a range has been written since then it cannot have changed
+    uint64_t prepGeneration;
+
+    // packets output and packets skipped as duplicates
+    std::atomic<uint64_t> packetCount;
+    std::atomic<uint64_t> duplicateCount;
+
     UDPOutputData(UDPOutputData const&) = delete;
     void operator=(UDPOutputData const& x) = delete;
 
 protected:
-    void SaveFrame(unsigned char* channelData, int len);
+    // Returns true if the count channels at savedIdx need to be sent.  When
+    // de-duplicating, the copy of what was last sent is updated in the same
+    // pass so there is nothing to save afterwards.
     bool NeedToOutputFrame(unsigned char* channelData, int startChannel, int savedIdx, int count);
     bool deDuplicate = false;
     int skippedFrames;
     unsigned char* lastData;
+    int lastDataSize;
 };
 
 class UDPOutput : public ChannelOutput {
@@ -119,6 +136,9 @@ public:
 
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override;
 
+    virtual void GetStats(Json::Value& result) override;
+    virtual void ResetStats() override;
+
     void addOutput(UDPOutputData*);
 
     int createSocket(int port = 0, bool broadCast = false, bool multiCast = false);
@@ -132,6 +152,11 @@ public:
 
 private:
     int SendMessages(unsigned int key, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs);
+    int TrySendMessages(unsigned int key, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs);
+    // Sends runs of equal sized messages to the same address as single
+    // UDP_SEGMENT (GSO) sends, everything else goes through sendmmsg.
+    // Returns the number of messages sent.
+    int SendSegmented(int sendSocket, SendSocketInfo* socketInfo, struct mmsghdr* msgs, int msgCount);
     struct sockaddr_in localAddress;
     std::string outInterface;
     bool needsBroadcast = false;
@@ -146,6 +171,7 @@ private:
     bool enabled;
 
     std::list<UDPOutputData*> outputs;
+    unsigned char* lastPrepData;
 
     int networkCallbackId;
 
@@ -155,21 +181,32 @@ private:
 
     class WorkItem {
     public:
-        WorkItem(unsigned int i, SendSocketInfo* si, std::vector<struct mmsghdr>& m) :
-            id(i),
-            socketInfo(si),
-            msgs(m) {}
         unsigned int id;
         SendSocketInfo* socketInfo;
-        std::vector<struct mmsghdr>& msgs;
+        std::vector<struct mmsghdr>* msgs;
     };
 
+    // A fixed pool of threads sends the per destination message batches.
+    // workItems is rebuilt in place each frame and the threads (and the
+    // output thread) claim items by index until they run out.  The work
+    // threads are kept off the CPU the output thread was on when started.
+    void StartWorkThreads();
+    void StopWorkThreads();
+    void DoWorkItems();
+    void SendWorkItem(const WorkItem& i);
+    bool WaitForWorkThreads(int ms);
+
     std::mutex workMutex;
     std::condition_variable workSignal;
-    std::list<WorkItem> workQueue;
+    std::condition_variable workDoneSignal;
+    std::vector<WorkItem> workItems;
+    std::vector<std::thread> workThreads;
+    uint32_t workGeneration;
+    std::atomic_int nextWorkItem;
     std::atomic_int doneWorkCount;
-    std::atomic_int numWorkThreads;
+    int activeWorkThreads;
     volatile bool runWorkThreads;
     bool useThreadedOutput;
     bool blockingOutput;
+    bool useSegmentation;
 };
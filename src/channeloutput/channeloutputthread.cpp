@@ -32,6 +32,7 @@
 #include "../mediaoutput/SDLOut.h"
 #include "../overlays/PixelOverlay.h"
 #include "../settings.h"
+#include "../util/TimingStats.h"
 
 #include "ChannelOutputSetup.h"
 #include "channeloutputthread.h"
@@ -62,6 +63,43 @@ std::condition_variable outputThreadSatusCond;
 /* prototypes for functions below */
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
 
+static TimingStats frameTimes;
+static TimingStats stageTimes[(int)OutputStage::Count];
+static const char* stageNames[(int)OutputStage::Count] = {
+    "send",
+    "read",
+    "process",
+    "bridgeMerge",
+    "pluginModify",
+    "effects",
+    "overlays",
+    "outputProcessors"
+};
+
+uint64_t RecordOutputStageTime(OutputStage stage, uint64_t startTime) {
+    uint64_t now = GetTimeMicros();
+    stageTimes[(int)stage].addSample(now - startTime);
+    return now;
+}
+
+void GetOutputTimingStats(Json::Value& result) {
+    frameTimes.toJson(result["frame"]);
+    for (int x = 0; x < (int)OutputStage::Count; x++) {
+        stageTimes[x].toJson(result["stages"][stageNames[x]]);
+    }
+    GetChannelOutputTimingStats(result["outputs"]);
+    PixelOverlayManager::INSTANCE.GetStats(result["overlays"]);
+}
+
+void ResetOutputTimingStats() {
+    frameTimes.reset();
+    for (auto& st : stageTimes) {
+        st.reset();
+    }
+    ResetChannelOutputTimingStats();
+    PixelOverlayManager::INSTANCE.ResetStats();
+}
+
 /*
  * Check to see if the channel output thread is running
  */
@@ -185,6 +223,7 @@ void* RunChannelOutputThread(void* data) {
         }
 
         sendTime = GetTime();
+        stageTimes[(int)OutputStage::Send].addSample(sendTime - startTime);
 
         if (sequence->IsSequenceRunning() || (onceMore >= 1)) {
             if (FrameSkip && sequence->IsSequenceRunning()) {
@@ -192,6 +231,7 @@ void* RunChannelOutputThread(void* data) {
                 FrameSkip = 0;
             }
             sequence->ReadSequenceData();
+            stageTimes[(int)OutputStage::Read].addSample(GetTime() - sendTime);
         }
         readTime = GetTime();
 
@@ -204,6 +244,7 @@ void* RunChannelOutputThread(void* data) {
             sequence->ProcessSequenceData(msTime);
         }
         processTime = GetTime();
+        stageTimes[(int)OutputStage::Process].addSample(processTime - readTime);
 
         long long totalTime = processTime - startTime;
         if (totalTime > 150000) {
@@ -231,6 +272,9 @@ void* RunChannelOutputThread(void* data) {
             // REMOTE mode keeps looping a few extra times before we blank
             onceMore = (getFPPmode() == REMOTE_MODE) ? 20 : 1;
             int sleepTime = LightDelay - (processTime - startTime);
+
+            frameTimes.setDeadline(LightDelay);
+            frameTimes.addSample(totalTime);
             
             // Calculate drift correction when sequence is running
             if (sequence->IsSequenceRunning() && frameStartTimeBase > 0) {
@@ -29,3 +29,21 @@ void ResetMasterPosition(void);
 void UpdateMasterPosition(int frameNumber);
 void CalculateNewChannelOutputDelay(float mediaPosition);
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
+
+// Stages of processing a frame that are timed for GetOutputTimingStats.
+// The per output PrepData/SendData times are kept with each output.
+enum class OutputStage {
+    Send,
+    Read,
+    Process,
+    BridgeMerge,
+    PluginModify,
+    Effects,
+    Overlays,
+    OutputProcessors,
+    Count
+};
+// records the time since startTime (GetTimeMicros) and returns the current time
+uint64_t RecordOutputStageTime(OutputStage stage, uint64_t startTime);
+void GetOutputTimingStats(Json::Value& result);
+void ResetOutputTimingStats();
@@ -22,6 +22,13 @@ public:
 
     virtual OutputProcessorType getType() const override { return BRIGHTNESS; }
 
+    virtual bool GetLookupTable(int& s, int& c, unsigned char* t) const override {
+        s = start;
+        c = count;
+        memcpy(t, table, 256);
+        return true;
+    }
+
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override {
         addRange(start, start + count - 1);
     }
@@ -22,6 +22,15 @@ public:
 
     virtual OutputProcessorType getType() const override { return CLAMPVALUE; }
 
+    virtual bool GetLookupTable(int& s, int& c, unsigned char* t) const override {
+        s = start;
+        c = count;
+        for (int x = 0; x < 256; x++) {
+            t[x] = x > value ? value : x;
+        }
+        return true;
+    }
+
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override {
         addRange(start, start + count - 1);
     }
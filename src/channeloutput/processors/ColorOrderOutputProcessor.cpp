@@ -32,6 +32,46 @@ ColorOrderOutputProcessor::ColorOrderOutputProcessor(const Json::Value& config)
 ColorOrderOutputProcessor::~ColorOrderOutputProcessor() {
 }
 
+bool ColorOrderOutputProcessor::GetGatherIndex(const std::function<void(int, int)>& addDestSource) const {
+    // offset of the source for each of the three channels
+    int src[3] = { 0, 1, 2 };
+    switch (order) {
+    case 132:
+        src[1] = 2;
+        src[2] = 1;
+        break;
+    case 213:
+        src[0] = 1;
+        src[1] = 0;
+        break;
+    case 231:
+        src[0] = 1;
+        src[1] = 2;
+        src[2] = 0;
+        break;
+    case 312:
+        src[0] = 2;
+        src[1] = 0;
+        src[2] = 1;
+        break;
+    case 321:
+        src[0] = 2;
+        src[2] = 0;
+        break;
+    default:
+        return true;
+    }
+    int cur = start;
+    for (int x = 0; x < count; x++, cur += 3) {
+        for (int c = 0; c < 3; c++) {
+            if (src[c] != c) {
+                addDestSource(cur + c, cur + src[c]);
+            }
+        }
+    }
+    return true;
+}
+
 void ColorOrderOutputProcessor::ProcessData(unsigned char* channelData) const {
     int cur = start;
     for (int x = 0; x < count; x++, cur += 3) {
@@ -22,6 +22,8 @@ public:
 
     virtual OutputProcessorType getType() const override { return COLORORDER; }
 
+    virtual bool GetGatherIndex(const std::function<void(int, int)>& addDestSource) const override;
+
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override {
         addRange(start, start + (count * 3) - 1);
     }
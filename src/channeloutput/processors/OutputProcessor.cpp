@@ -12,7 +12,11 @@
 
 #include "fpp-pch.h"
 
+#include <unordered_map>
+
 #include "../../log.h"
+#include "../../util/DirtyRanges.h"
+#include "../ChannelOutputSetup.h"
 
 #include "OutputProcessor.h"
 
@@ -40,11 +44,288 @@ OutputProcessors::~OutputProcessors() {
 
 void OutputProcessors::ProcessData(unsigned char* channelData) const {
     std::lock_guard<std::mutex> lock(processorsLock);
+    if (needsCompile) {
+        compile();
+    }
+    for (auto& step : compiledSteps) {
+        step.ProcessData(channelData);
+    }
+}
+
+static inline void GatherRunData(unsigned char* out, const unsigned char* in, int source, int count, int step) {
+    if (step == 1) {
+        memcpy(out, in + source, count);
+    } else if (step == 0) {
+        memset(out, in[source], count);
+    } else {
+        const unsigned char* src = in + source;
+        for (int x = 0; x < count; x++) {
+            out[x] = src[-x];
+        }
+    }
+}
+
+// Lookups and gathers always give the same output for the same input so
+// their channels only change when the channels they read did.  Those were
+// marked by whatever wrote them this frame, so only gather destinations
+// need marking.  Other processors may keep state so what they write is
+// compared to what they wrote last frame.
+void OutputProcessors::CompiledStep::ProcessData(unsigned char* channelData) const {
+    uint64_t generation = channelDataChanges.getGeneration();
+    switch (type) {
+    case PROCESSOR: {
+        processor->ProcessData(channelData);
+        unsigned char* last = lastOutput.data();
+        for (auto& r : outputRanges) {
+            if (memcmp(last, channelData + r.first, r.second)) {
+                memcpy(last, channelData + r.first, r.second);
+                channelDataChanges.markDirty(r.first, r.second);
+            }
+            last += r.second;
+        }
+    } break;
+    case LOOKUP:
+        for (auto& r : ranges) {
+            const unsigned char* table = &tables[r.table][0];
+            unsigned char* data = channelData + r.start;
+            for (int x = 0; x < r.count; x++) {
+                data[x] = table[data[x]];
+            }
+        }
+        break;
+    case GATHER:
+        if (needsScratch) {
+            // some destinations are also sources, read everything first
+            unsigned char* s = &scratch[0];
+            for (auto& r : runs) {
+                GatherRunData(s, channelData, r.source, r.count, r.step);
+                s += r.count;
+            }
+            s = &scratch[0];
+            for (auto& r : runs) {
+                memcpy(channelData + r.dest, s, r.count);
+                s += r.count;
+            }
+        } else {
+            for (auto& r : runs) {
+                GatherRunData(channelData + r.dest, channelData, r.source, r.count, r.step);
+            }
+        }
+        for (auto& r : runs) {
+            // a destination that is also a source may have just been
+            // marked, that only ever marks more than needed
+            int first = r.step < 0 ? r.source - r.count + 1 : r.source;
+            if (channelDataChanges.isDirty(first, r.step == 0 ? 1 : r.count, generation)) {
+                channelDataChanges.markDirty(r.dest, r.count);
+            }
+        }
+        break;
+    }
+}
+
+// Everything the step can write, for when the steps are recompiled
+void OutputProcessors::CompiledStep::MarkOutputDirty() const {
+    for (auto& r : outputRanges) {
+        channelDataChanges.markDirty(r.first, r.second);
+    }
+    for (auto& r : ranges) {
+        channelDataChanges.markDirty(r.start, r.count);
+    }
+    for (auto& r : runs) {
+        channelDataChanges.markDirty(r.dest, r.count);
+    }
+}
+
+// must be called with the processorsLock held
+void OutputProcessors::compile() const {
+    // the old steps' channels go back to their unprocessed values and the
+    // new steps' get processed differently
+    for (auto& step : compiledSteps) {
+        step.MarkOutputDirty();
+    }
+    compiledSteps.clear();
+
+    std::vector<OutputProcessor*> lookups;
+    std::vector<OutputProcessor*> gathers;
+    unsigned char table[256];
+    int start, count;
     for (OutputProcessor* a : processors) {
-        if (a->isActive()) {
-            a->ProcessData(channelData);
+        if (!a->isActive()) {
+            continue;
+        }
+        if (a->GetLookupTable(start, count, table)) {
+            compileGathers(gathers);
+            lookups.push_back(a);
+        } else if (a->GetGatherIndex([](int, int) {})) {
+            compileLookups(lookups);
+            gathers.push_back(a);
+        } else {
+            compileLookups(lookups);
+            compileGathers(gathers);
+            compiledSteps.emplace_back();
+            CompiledStep& step = compiledSteps.back();
+            step.processor = a;
+            int total = 0;
+            a->GetRequiredChannelRanges([&step, &total](int min, int max) {
+                // some processors give an inclusive max, some don't
+                min = std::max(min, 0);
+                max = std::min(max, FPPD_MAX_CHANNELS - 1);
+                if (max >= min) {
+                    step.outputRanges.emplace_back(min, max - min + 1);
+                    total += max - min + 1;
+                }
+            });
+            step.lastOutput.resize(total);
         }
     }
+    compileLookups(lookups);
+    compileGathers(gathers);
+    for (auto& step : compiledSteps) {
+        step.MarkOutputDirty();
+    }
+    needsCompile = false;
+
+    LogDebug(VB_CHANNELOUT, "Compiled %d output processors into %d steps\n", (int)processors.size(), (int)compiledSteps.size());
+}
+
+// Split the channels covered by the processors into ranges where the same set
+// of processors apply and build a single combined table for each range.
+void OutputProcessors::compileLookups(std::vector<OutputProcessor*>& procs) const {
+    if (procs.empty()) {
+        return;
+    }
+    std::vector<std::array<unsigned char, 256>> procTables(procs.size());
+    std::vector<std::pair<int, int>> procRanges(procs.size());
+    std::vector<int> bounds;
+    for (int i = 0; i < procs.size(); i++) {
+        int start = 0;
+        int count = 0;
+        procs[i]->GetLookupTable(start, count, &procTables[i][0]);
+        if (start < 0) {
+            count += start;
+            start = 0;
+        }
+        if (count < 0) {
+            count = 0;
+        }
+        procRanges[i] = std::pair<int, int>(start, start + count);
+        if (count) {
+            bounds.push_back(start);
+            bounds.push_back(start + count);
+        }
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    CompiledStep step;
+    step.type = CompiledStep::LOOKUP;
+    for (int b = 0; b + 1 < bounds.size(); b++) {
+        int rangeStart = bounds[b];
+        int rangeEnd = bounds[b + 1];
+
+        std::array<unsigned char, 256> table;
+        for (int x = 0; x < 256; x++) {
+            table[x] = x;
+        }
+        for (int i = 0; i < procs.size(); i++) {
+            if (procRanges[i].first <= rangeStart && procRanges[i].second >= rangeEnd) {
+                for (int x = 0; x < 256; x++) {
+                    table[x] = procTables[i][table[x]];
+                }
+            }
+        }
+        bool identity = true;
+        for (int x = 0; x < 256 && identity; x++) {
+            identity = table[x] == x;
+        }
+        if (identity) {
+            continue;
+        }
+        if (!step.ranges.empty()) {
+            auto& last = step.ranges.back();
+            if ((last.start + last.count) == rangeStart && step.tables[last.table] == table) {
+                last.count += rangeEnd - rangeStart;
+                continue;
+            }
+        }
+        int idx = std::find(step.tables.begin(), step.tables.end(), table) - step.tables.begin();
+        if (idx == step.tables.size()) {
+            step.tables.push_back(table);
+        }
+        step.ranges.push_back({ rangeStart, rangeEnd - rangeStart, idx });
+    }
+    if (!step.ranges.empty()) {
+        compiledSteps.push_back(std::move(step));
+    }
+    procs.clear();
+}
+
+// Resolve the chain of processors into the original source channel for each
+// destination and then collapse that into runs of channels that can be copied
+// together.
+void OutputProcessors::compileGathers(std::vector<OutputProcessor*>& procs) const {
+    if (procs.empty()) {
+        return;
+    }
+    std::unordered_map<int, int> sources;
+    std::vector<std::pair<int, int>> pairs;
+    for (auto p : procs) {
+        pairs.clear();
+        p->GetGatherIndex([&pairs](int dest, int source) {
+            pairs.emplace_back(dest, source);
+        });
+        // sources are read before this processor writes anything
+        for (auto& ds : pairs) {
+            auto it = sources.find(ds.second);
+            if (it != sources.end()) {
+                ds.second = it->second;
+            }
+        }
+        for (auto& ds : pairs) {
+            sources[ds.first] = ds.second;
+        }
+    }
+    pairs.clear();
+    for (auto& ds : sources) {
+        if (ds.first != ds.second && ds.first >= 0 && ds.second >= 0) {
+            pairs.emplace_back(ds.first, ds.second);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    CompiledStep step;
+    step.type = CompiledStep::GATHER;
+    for (auto& ds : pairs) {
+        if (!step.runs.empty()) {
+            auto& last = step.runs.back();
+            if (last.dest + last.count == ds.first) {
+                if (last.count == 1) {
+                    int diff = ds.second - last.source;
+                    if (diff >= -1 && diff <= 1) {
+                        last.step = diff;
+                        last.count++;
+                        continue;
+                    }
+                } else if (last.source + last.step * last.count == ds.second) {
+                    last.count++;
+                    continue;
+                }
+            }
+        }
+        step.runs.push_back({ ds.first, ds.second, 1, 1 });
+    }
+    for (auto& ds : pairs) {
+        if (std::binary_search(pairs.begin(), pairs.end(), std::pair<int, int>(ds.second, INT_MIN),
+                               [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; })) {
+            step.needsScratch = true;
+            step.scratch.resize(pairs.size());
+            break;
+        }
+    }
+    if (!step.runs.empty()) {
+        compiledSteps.push_back(std::move(step));
+    }
+    procs.clear();
 }
 
 void OutputProcessors::addProcessor(OutputProcessor* p) {
@@ -53,10 +334,12 @@ void OutputProcessors::addProcessor(OutputProcessor* p) {
     }
     std::lock_guard<std::mutex> lock(processorsLock);
     processors.push_back(p);
+    needsCompile = true;
 }
 void OutputProcessors::removeProcessor(OutputProcessor* p) {
     std::lock_guard<std::mutex> lock(processorsLock);
     processors.remove(p);
+    needsCompile = true;
 }
 void OutputProcessors::removeAll() {
     std::lock_guard<std::mutex> lock(processorsLock);
@@ -64,6 +347,7 @@ void OutputProcessors::removeAll() {
         delete a;
     }
     processors.clear();
+    needsCompile = true;
 }
 
 void OutputProcessors::loadFromJSON(const Json::Value& config) {
@@ -76,6 +360,7 @@ void OutputProcessors::loadFromJSON(const Json::Value& config) {
         delete a;
     }
     fromJsonProcessors.clear();
+    needsCompile = true;
     lock.unlock();
 
     for (Json::Value::const_iterator itr = config.begin(); itr != config.end(); ++itr) {
@@ -12,7 +12,9 @@
  */
 
 #include "../../Sequence.h"
+#include <array>
 #include <functional>
+#include <vector>
 
 class OutputProcessor {
 public:
@@ -46,6 +48,16 @@ public:
         max = FPPD_MAX_CHANNELS;
     }
 
+    // Processors that just run each channel in a range through a 256 entry
+    // table can return the table so OutputProcessors can fuse them together
+    virtual bool GetLookupTable(int& start, int& count, unsigned char* table) const { return false; }
+
+    // Processors that just move channel values around can report the source
+    // channel for each destination channel so OutputProcessors can fuse them
+    // into a single gather.  All sources are read before any destination is
+    // written.
+    virtual bool GetGatherIndex(const std::function<void(int, int)>& addDestSource) const { return false; }
+
 protected:
     std::string description;
     bool active;
@@ -71,9 +83,55 @@ protected:
     void removeAll();
     OutputProcessor* create(const Json::Value& config);
 
+    // The processors are "compiled" into a list of steps the first time
+    // ProcessData is called after the list changes.  Adjacent lookup table
+    // processors become one table per channel range and adjacent gather
+    // processors become one list of copy runs.  Anything else is called
+    // as is.
+    class CompiledStep {
+    public:
+        enum StepType {
+            PROCESSOR,
+            LOOKUP,
+            GATHER
+        };
+        class LookupRange {
+        public:
+            int start;
+            int count;
+            int table;
+        };
+        class GatherRun {
+        public:
+            int dest;
+            int source;
+            int count;
+            int step; // 1, -1 (reversed) or 0 (repeated source)
+        };
+
+        StepType type = PROCESSOR;
+        OutputProcessor* processor = nullptr;
+        std::vector<LookupRange> ranges;
+        std::vector<std::array<unsigned char, 256>> tables;
+        std::vector<GatherRun> runs;
+        bool needsScratch = false;
+        mutable std::vector<unsigned char> scratch;
+        // channels a PROCESSOR step may write and what it wrote last frame
+        std::vector<std::pair<int, int>> outputRanges;
+        mutable std::vector<unsigned char> lastOutput;
+
+        void ProcessData(unsigned char* channelData) const;
+        void MarkOutputDirty() const;
+    };
+    void compile() const;
+    void compileLookups(std::vector<OutputProcessor*>& procs) const;
+    void compileGathers(std::vector<OutputProcessor*>& procs) const;
+
     mutable std::mutex processorsLock;
     std::list<OutputProcessor*> processors;
     std::list<OutputProcessor*> fromJsonProcessors;
+    mutable std::vector<CompiledStep> compiledSteps;
+    mutable bool needsCompile = true;
 };
 
 void ProcessModelConfig(const Json::Value& config, std::string& model, int& start, int& count);
@@ -22,6 +22,16 @@ public:
 
     virtual OutputProcessorType getType() const override { return OVERRIDEZERO; }
 
+    virtual bool GetLookupTable(int& s, int& c, unsigned char* t) const override {
+        s = start;
+        c = count;
+        for (int x = 0; x < 256; x++) {
+            t[x] = x;
+        }
+        t[0] = value;
+        return true;
+    }
+
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override {
         addRange(start, start + count - 1);
     }
@@ -54,6 +54,56 @@ void RemapOutputProcessor::GetRequiredChannelRanges(const std::function<void(int
     addRange(min, max);
 }
 
+bool RemapOutputProcessor::GetGatherIndex(const std::function<void(int, int)>& addDestSource) const {
+    if (reverse < 0 || reverse > 3) {
+        return false;
+    }
+    if (count <= 0) {
+        return true;
+    }
+    // source for each channel of the first loop, -1 if not written
+    std::vector<int> first(count, -1);
+    int pixelSize = reverse + 1;
+    if (count == 1) {
+        first[0] = sourceChannel;
+    } else if (reverse == 0) {
+        for (int c = 0; c < count; c++) {
+            first[c] = sourceChannel + c;
+        }
+    } else if (reverse == 1) {
+        for (int c = 0; c < count; c++) {
+            first[c] = sourceChannel + count - 1 - c;
+        }
+    } else {
+        for (int c = 0; c < count - reverse; c += pixelSize) {
+            for (int p = 0; p < pixelSize; p++) {
+                first[c + p] = sourceChannel + count - pixelSize - c + p;
+            }
+        }
+    }
+    for (int l = 0; l < loops; l++) {
+        for (int c = 0; c < count; c++) {
+            if (first[c] >= 0) {
+                addDestSource(destChannel + (l * count) + c, first[c]);
+            } else if (l) {
+                // later loops copy the whole first block, even the parts not written
+                addDestSource(destChannel + (l * count) + c, destChannel + c);
+            }
+        }
+    }
+    return true;
+}
+
+unsigned char* RemapOutputProcessor::getTempBuffer(int size) {
+    // only ever used from the output thread, keep it around instead of
+    // allocating a new one every frame
+    static thread_local std::vector<unsigned char> tempBuffer;
+    if (tempBuffer.size() < (size_t)size) {
+        tempBuffer.resize(size);
+    }
+    return &tempBuffer[0];
+}
+
 void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
     switch (reverse) {
     case 0: // No reverse
@@ -73,13 +123,11 @@ void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
             if (count > 1) {
                 if (!l) { // First loop, reverse while copying
                     // Copy the required section of channel data to a temporary buffer
-                    unsigned char* tempBuffer = new unsigned char[count];
+                    unsigned char* tempBuffer = getTempBuffer(count);
                     memcpy(tempBuffer, channelData + sourceChannel, count);
                     for (int c = 0; c < count; c++) {
                         channelData[destChannel + c] = tempBuffer[count - 1 - c];
                     }
-                    // Delete the temporary buffer
-                    delete[] tempBuffer;
                 } else { // Subsequent loops, just copy first reversed block for speed
                     memcpy(channelData + destChannel + (l * count),
                            channelData + destChannel,
@@ -96,7 +144,7 @@ void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
             if (count > 1) {
                 if (!l) { // First loop, reverse pixels while copying
                     // Copy the required section of channel data to a temporary buffer
-                    unsigned char* tempBuffer = new unsigned char[count];
+                    unsigned char* tempBuffer = getTempBuffer(count);
                     memcpy(tempBuffer, channelData + sourceChannel, count);
                     for (int c = 0; c < count - 2;) {
                         channelData[destChannel + c + 0] = tempBuffer[count - 1 - c - 2];
@@ -104,8 +152,6 @@ void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
                         channelData[destChannel + c + 2] = tempBuffer[count - 1 - c - 0];
                         c += 3;
                     }
-                    // Delete the temporary buffer
-                    delete[] tempBuffer;
                 } else { // Subsequent loops, just copy first reversed block for speed
                     memcpy(channelData + destChannel + (l * count),
                            channelData + destChannel,
@@ -123,7 +169,7 @@ void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
             if (count > 1) {
                 if (!l) { // First loop, reverse pixels while copying
                     // Copy the required section of channel data to a temporary buffer
-                    unsigned char* tempBuffer = new unsigned char[count];
+                    unsigned char* tempBuffer = getTempBuffer(count);
                     memcpy(tempBuffer, channelData + sourceChannel, count);
                     for (int c = 0; c < count - 3;) {
                         channelData[destChannel + c + 0] = tempBuffer[count - 1 - c - 3];
@@ -132,8 +178,6 @@ void RemapOutputProcessor::ProcessData(unsigned char* channelData) const {
                         channelData[destChannel + c + 3] = tempBuffer[count - 1 - c - 0];
                         c += 4;
                     }
-                    // Delete the temporary buffer
-                    delete[] tempBuffer;
                 } else { // Subsequent loops, just copy first reversed block for speed
                     memcpy(channelData + destChannel + (l * count),
                            channelData + destChannel,
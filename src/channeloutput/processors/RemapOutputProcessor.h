@@ -31,7 +31,11 @@ public:
 
     virtual void GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) override;
 
+    virtual bool GetGatherIndex(const std::function<void(int, int)>& addDestSource) const override;
+
 protected:
+    static unsigned char* getTempBuffer(int size);
+
     int sourceChannel;
     int destChannel;
     int count;
@@ -26,6 +26,7 @@
 uint8_t* PixelCountPixelStringTester::createTestData(PixelString* ps, int cycleCount, float percentOfCycle, uint8_t* inChannelData, uint32_t& newLen) {
     newLen = ps->m_outputChannels;
     uint8_t* data = ps->m_outputBuffer;
+    ps->outputBufferModified();
     uint8_t* out = data;
     uint32_t inCh = 0;
     unsigned char clr[6];
@@ -258,6 +259,7 @@ void CurrentBasedPixelCountPixelStringTester::prepareTestData(int cycleCount, fl
 uint8_t* CurrentBasedPixelCountPixelStringTester::createTestData(PixelString* ps, int cycleCount, float percentOfCycle, uint8_t* inChannelData, uint32_t& newLen) {
     newLen = 2000; // up to 500 4channel pixels
     uint8_t* buffer = ps->m_outputBuffer;
+    ps->outputBufferModified();
     int currentPort = ps->m_portNumber;
 
     if (currentState == STATE_WARMUP) {
@@ -18,6 +18,7 @@
 uint8_t* PixelFadeStringTester::createTestData(PixelString* ps, int cycleCount, float percentOfCycle, uint8_t* inChannelData, uint32_t &newLen) {
     newLen = ps->m_outputChannels;
     uint8_t* data = ps->m_outputBuffer;
+    ps->outputBufferModified();
     memset(data, 0, ps->m_outputChannels);
     uint8_t* out = data;
     uint32_t inCh = 0;
@@ -18,6 +18,7 @@
 uint8_t* OutputPortNumberPixelStringTester::createTestData(PixelString* ps, int cycleCount, float percentOfCycle, uint8_t* inChannelData, uint32_t &newLen) {
     newLen = ps->m_outputChannels;
     uint8_t* data = ps->m_outputBuffer;
+    ps->outputBufferModified();
     uint8_t* out = data;
     uint32_t inCh = 0;
     unsigned char clr[3];
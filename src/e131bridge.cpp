@@ -74,6 +74,7 @@ struct iovec iovecs[MAX_MSG];
 uint8_t buffers[MAX_MSG][BUFSIZE + 1];
 struct sockaddr_in inAddress[MAX_MSG];
 
+// universe number -> InputUniverses index, rebuilt whenever the inputs change
 unsigned int UniverseCache[65536];
 
 std::vector<UniverseEntry> InputUniverses;
@@ -116,6 +117,8 @@ void BridgeShutdownUDP();
 int Bridge_GetIndexFromUniverseNumber(int universe);
 void InputUniversesPrint();
 inline void SetBridgeData(uint8_t* data, int startChannel, int len, long long packetTime);
+inline void SetBridgeUniverseData(uint32_t universeIndex, uint8_t* data, int len, long long packetTime);
+static void UpdateUniverseTable();
 
 int CreateArtNetSocket(uint32_t sourceAddr) {
     if (artnetSock < 0) {
@@ -250,6 +253,32 @@ inline void SetBridgeData(uint8_t* data, int startChannel, int len, long long pa
     bridgeDataReceived = true;
     sequence->SetBridgeData(data, startChannel, len, packetTime);
 }
+inline void SetBridgeUniverseData(uint32_t universeIndex, uint8_t* data, int len, long long packetTime) {
+    last_packet_time = packetTime;
+    bridgeDataReceived = true;
+    sequence->SetBridgeUniverseData(universeIndex, data, len, packetTime + expireOffSet);
+}
+
+// Build the universe number lookup and register the universe ranges with
+// the sequence so the receive path doesn't need to search or lock anything
+static void UpdateUniverseTable() {
+    for (int i = 0; i < 65536; i++) {
+        UniverseCache[i] = BRIDGE_INVALID_UNIVERSE_INDEX;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    ranges.reserve(InputUniverseCount);
+    for (int i = 0; i < InputUniverseCount; i++) {
+        if (InputUniverses[i].type != DMX_TYPE) {
+            uint32_t universe = InputUniverses[i].universe;
+            if (universe < 65536 && UniverseCache[universe] == BRIDGE_INVALID_UNIVERSE_INDEX) {
+                UniverseCache[universe] = i;
+            }
+        }
+        // DMX inputs are just placeholders to keep the indexes the same
+        ranges.emplace_back(std::max(InputUniverses[i].startAddress, 1u) - 1, InputUniverses[i].type == DMX_TYPE ? 0 : InputUniverses[i].size);
+    }
+    sequence->SetBridgeUniverses(ranges);
+}
 
 /*
  * Read data waiting for us
@@ -315,13 +344,9 @@ bool Bridge_Initialize_Internal() {
         msgs[i].msg_hdr.msg_name = &inAddress[i];
     }
 
-    /* Initialize our Universe Index lookup cache */
-    for (int i = 0; i < 65536; i++) {
-        UniverseCache[i] = BRIDGE_INVALID_UNIVERSE_INDEX;
-    }
-
     bool enabled = LoadInputUniversesFromFile();
     hasUDP = enabled;
+    UpdateUniverseTable();
     bool disableFakeBridges = getSettingInt("DisableFakeNetworkBridges");
 
     LogInfo(VB_E131BRIDGE, "Universe Count = %d\n", InputUniverseCount);
@@ -529,10 +554,9 @@ bool Bridge_StoreData(uint8_t* bridgeBuffer, long long packetTime) {
             }
             InputUniverses[universeIndex].lastSequenceNumber = sn;
 
-            SetBridgeData(&bridgeBuffer[E131_HEADER_LENGTH],
-                          InputUniverses[universeIndex].startAddress - 1,
-                          InputUniverses[universeIndex].size,
-                          packetTime);
+            SetBridgeUniverseData(universeIndex, &bridgeBuffer[E131_HEADER_LENGTH],
+                                  InputUniverses[universeIndex].size,
+                                  packetTime);
             InputUniverses[universeIndex].bytesReceived += InputUniverses[universeIndex].size;
             InputUniverses[universeIndex].packetsReceived++;
         } else {
@@ -591,10 +615,9 @@ bool Bridge_StoreArtNetData(uint8_t* bridgeBuffer, long long packetTime) {
             InputUniverses[universeIndex].bytesReceived += std::min(InputUniverses[universeIndex].size, len);
             InputUniverses[universeIndex].packetsReceived++;
 
-            SetBridgeData(&bridgeBuffer[18],
-                          InputUniverses[universeIndex].startAddress - 1,
-                          std::min(InputUniverses[universeIndex].size, len),
-                          packetTime);
+            SetBridgeUniverseData(universeIndex, &bridgeBuffer[18],
+                                  std::min(InputUniverses[universeIndex].size, len),
+                                  packetTime);
 
         } else {
             unknownUniverse.packetsReceived++;
@@ -749,19 +772,7 @@ bool Bridge_StoreDDPData(uint8_t* bridgeBuffer, long long packetTime) {
 }
 
 inline int Bridge_GetIndexFromUniverseNumber(int universe) {
-    int val = BRIDGE_INVALID_UNIVERSE_INDEX;
-
-    if (UniverseCache[universe] != BRIDGE_INVALID_UNIVERSE_INDEX)
-        return UniverseCache[universe];
-
-    for (int index = 0; index < InputUniverseCount; index++) {
-        if (universe == InputUniverses[index].universe) {
-            val = index;
-            UniverseCache[universe] = index;
-            break;
-        }
-    }
-    return val;
+    return UniverseCache[universe & 0xFFFF];
 }
 
 void ResetBytesReceived() {
@@ -1027,6 +1038,8 @@ static void BridgeReloadDMXInputs() {
             }
         }
     }
+    // the UDP universes may have moved
+    UpdateUniverseTable();
 }
 
 void BridgeReloadUDP() {
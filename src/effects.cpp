@@ -13,16 +13,21 @@
 #include "fpp-pch.h"
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
 #include <fnmatch.h>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -31,20 +36,62 @@
 #include "common.h"
 #include "log.h"
 #include "settings.h"
+#include "channeloutput/ChannelOutputSetup.h"
 #include "channeloutput/channeloutputthread.h"
 #include "commands/Commands.h" // lines 58-58
 #include "fseq/FSEQFile.h"
+#include "util/DirtyRanges.h"
+#include "util/SPSCRing.h"
 
 #include "effects.h"
 
 #define MAX_EFFECTS 100
 
+// Effects that decode to less than this are decoded once and kept in
+// memory, up to EFFECT_CACHE_MAX_SIZE total across all cached effects
+#define EFFECT_CACHE_MAX_EFFECT_SIZE (4 * 1024 * 1024)
+#define EFFECT_CACHE_MAX_SIZE (32 * 1024 * 1024)
+#define EFFECT_READ_AHEAD_FRAMES 10
+
+class EffectFrameCache {
+public:
+    ~EffectFrameCache() {
+        for (auto f : frames) {
+            delete f;
+        }
+    }
+
+    std::vector<FSEQFile::FrameData*> frames;
+    size_t size = 0;
+    uint64_t lastUsed = 0;
+    bool complete = false;
+};
+
+static std::map<std::string, std::shared_ptr<EffectFrameCache>> effectCache;
+static size_t effectCacheSize = 0;
+static std::mutex effectCacheLock;
+
 class FPPeffect {
 public:
     FPPeffect() :
         fp(nullptr),
-        currentFrame(0) {}
+        currentFrame(0),
+        readRing(EFFECT_READ_AHEAD_FRAMES),
+        recycleRing(EFFECT_READ_AHEAD_FRAMES + 2) {}
     ~FPPeffect() {
+        if (readThread) {
+            stopReading = true;
+            readSignal.notify_all();
+            readThread->join();
+            delete readThread;
+        }
+        FSEQFile::FrameData* d;
+        while (readRing.pop(d)) {
+            delete d;
+        }
+        while (recycleRing.pop(d)) {
+            delete d;
+        }
         if (fp)
             delete fp;
     }
@@ -54,6 +101,30 @@ public:
     int loop;
     int background;
     uint32_t currentFrame;
+
+    // Frames are never read on the output thread.  Small effects are
+    // decoded up front into a cache (shared with later runs of the same
+    // effect), others are read ahead into readRing by readThread which
+    // owns fp until it exits.  A nullptr in readRing marks the end.
+    // While the cache is being decoded the frames decoded so far are
+    // played from it.
+    std::shared_ptr<EffectFrameCache> cache;
+    std::string cacheKey;
+    std::atomic_bool cacheReady = false;
+    std::atomic<uint32_t> decodedFrames = 0;
+
+    std::thread* readThread = nullptr;
+    std::atomic_bool stopReading = false;
+    SPSCRing<FSEQFile::FrameData*> readRing;
+    SPSCRing<FSEQFile::FrameData*> recycleRing;
+    std::mutex readLock;
+    std::condition_variable readSignal;
+
+    void StartReading();
+    void DecodeFrames();
+    void ReadFrames();
+    FSEQFile::FrameData* NextFrame(bool& ready);
+    void ReleaseFrame(FSEQFile::FrameData* d);
 };
 
 static int effectCount = 0;
@@ -62,6 +133,159 @@ static std::array<FPPeffect*, MAX_EFFECTS> effects;
 static std::list<std::pair<uint32_t, uint32_t>> clearRanges;
 static std::mutex effectsLock;
 
+static void GetEffectRanges(FPPeffect* e, const std::function<void(uint32_t, uint32_t)>& addRange);
+
+void FPPeffect::StartReading() {
+    size_t frameSize = 0;
+    GetEffectRanges(this, [&frameSize](uint32_t start, uint32_t count) {
+        frameSize += count;
+    });
+    size_t size = frameSize * fp->getNumFrames();
+
+    if (size <= EFFECT_CACHE_MAX_EFFECT_SIZE) {
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        stat(fp->getFilename().c_str(), &st);
+        uint32_t firstChannel = 0;
+        GetEffectRanges(this, [&firstChannel](uint32_t start, uint32_t count) {
+            if (!firstChannel)
+                firstChannel = start + 1;
+        });
+        // start channel is part of the key as the frames are read with it applied
+        cacheKey = fp->getFilename() + ":" + std::to_string(st.st_mtime) + ":" + std::to_string(st.st_size) + ":" + std::to_string(firstChannel);
+
+        std::unique_lock<std::mutex> lock(effectCacheLock);
+        auto it = effectCache.find(cacheKey);
+        if (it == effectCache.end()) {
+            cache = std::make_shared<EffectFrameCache>();
+            cache->size = size;
+            effectCache[cacheKey] = cache;
+            effectCacheSize += size;
+        } else if (it->second->complete) {
+            cache = it->second;
+            cache->lastUsed = GetTimeMS();
+            cacheReady = true;
+            LogDebug(VB_EFFECT, "Using cached frames for effect %s\n", name.c_str());
+            return;
+        }
+        // else another run is still decoding it, just read this one normally
+    }
+
+    readThread = new std::thread([this]() {
+        SetThreadName("FPP-EffectRead");
+        if (cache) {
+            DecodeFrames();
+        } else {
+            ReadFrames();
+        }
+    });
+}
+
+void FPPeffect::DecodeFrames() {
+    uint64_t start = GetTimeMS();
+    uint32_t numFrames = fp->getNumFrames();
+    // reserved up front so frames already being played never move
+    cache->frames.reserve(numFrames);
+    for (uint32_t f = 0; f < numFrames && !stopReading; f++) {
+        FSEQFile::FrameData* d = fp->getFrame(f);
+        if (!d) {
+            break;
+        }
+        cache->frames.push_back(d);
+        decodedFrames = f + 1;
+    }
+
+    std::unique_lock<std::mutex> lock(effectCacheLock);
+    if (stopReading) {
+        // stopped before it was fully decoded, don't keep it
+        effectCache.erase(cacheKey);
+        effectCacheSize -= cache->size;
+        return;
+    }
+    cache->complete = true;
+    cache->lastUsed = GetTimeMS();
+    LogDebug(VB_EFFECT, "Decoded %d frames of effect %s in %dms\n",
+             (int)cache->frames.size(), name.c_str(), (int)(cache->lastUsed - start));
+
+    // drop the least recently used effects nothing is playing until we're under budget
+    while (effectCacheSize > EFFECT_CACHE_MAX_SIZE) {
+        auto oldest = effectCache.end();
+        for (auto it = effectCache.begin(); it != effectCache.end(); ++it) {
+            if (it->second->complete && (it->second.use_count() == 1) &&
+                ((oldest == effectCache.end()) || (it->second->lastUsed < oldest->second->lastUsed))) {
+                oldest = it;
+            }
+        }
+        if (oldest == effectCache.end()) {
+            break;
+        }
+        effectCacheSize -= oldest->second->size;
+        effectCache.erase(oldest);
+    }
+    lock.unlock();
+
+    cacheReady = true;
+}
+
+void FPPeffect::ReadFrames() {
+    uint32_t frame = 0;
+    while (!stopReading) {
+        if (readRing.full()) {
+            std::unique_lock<std::mutex> lock(readLock);
+            readSignal.wait_for(lock, std::chrono::milliseconds(fp->getStepTime()));
+            continue;
+        }
+        FSEQFile::FrameData* recycle = nullptr;
+        recycleRing.pop(recycle);
+        FSEQFile::FrameData* d = fp->getFrame(frame, recycle);
+        if (!d && loop && frame) {
+            frame = 0;
+            d = fp->getFrame(frame);
+        }
+        readRing.push(d);
+        if (!d) {
+            return;
+        }
+        frame++;
+    }
+}
+
+// Returns the next frame to overlay or nullptr at the end of the effect.
+// ready is false if the frame isn't available yet.
+FSEQFile::FrameData* FPPeffect::NextFrame(bool& ready) {
+    FSEQFile::FrameData* d = nullptr;
+    ready = true;
+    if (cacheReady) {
+        if ((currentFrame >= cache->frames.size()) && loop) {
+            currentFrame = 0;
+        }
+        if (currentFrame < cache->frames.size()) {
+            d = cache->frames[currentFrame];
+        }
+    } else if (cache) {
+        if (currentFrame >= decodedFrames) {
+            ready = false;
+            return nullptr;
+        }
+        d = cache->frames[currentFrame];
+    } else if (!readRing.pop(d)) {
+        ready = false;
+        return nullptr;
+    }
+    currentFrame++;
+    return d;
+}
+
+void FPPeffect::ReleaseFrame(FSEQFile::FrameData* d) {
+    if (cache) {
+        return; // owned by the cache
+    }
+    if (!recycleRing.push(d)) {
+        delete d;
+    }
+    readSignal.notify_one();
+}
+
 /*
  * Initialize effects constructs
  */
@@ -172,6 +396,7 @@ int StartEffect(FSEQFile* fseq, const std::string& effectName, int loop, bool bg
     effects[effectID]->fp = fseq;
     effects[effectID]->loop = loop;
     effects[effectID]->background = bg;
+    effects[effectID]->StartReading();
 
     effectCount++;
     int tmpec = effectCount;
@@ -234,6 +459,24 @@ int StartEffect(const std::string& effectName, int startChannel, int loop, bool
     return StartEffect(v2fseq, effectName, loop, bg);
 }
 
+/*
+ * Get the channel ranges an effect writes to
+ */
+static void GetEffectRanges(FPPeffect* e, const std::function<void(uint32_t, uint32_t)>& addRange) {
+    V2FSEQFile* v2fseq = dynamic_cast<V2FSEQFile*>(e->fp);
+    if (v2fseq && v2fseq->m_sparseRanges.size() != 0) {
+        for (auto& a : v2fseq->m_sparseRanges) {
+            addRange(a.first, a.second);
+        }
+        for (auto& a : v2fseq->m_rangesToRead) {
+            addRange(a.first, a.second);
+        }
+    } else {
+        // not sparse and not eseq, entire range
+        addRange(0, e->fp->getChannelCount());
+    }
+}
+
 /*
  * Helper function to stop an effect, assumes effectsLock is already held
  */
@@ -242,18 +485,9 @@ void StopEffectHelper(int effectID) {
     e = effects[effectID];
 
     if (e->fp) {
-        V2FSEQFile* v2fseq = dynamic_cast<V2FSEQFile*>(e->fp);
-        if (v2fseq && v2fseq->m_sparseRanges.size() != 0) {
-            for (auto& a : v2fseq->m_sparseRanges) {
-                clearRanges.push_back(std::pair<uint32_t, uint32_t>(a.first, a.second));
-            }
-            for (auto& a : v2fseq->m_rangesToRead) {
-                clearRanges.push_back(std::pair<uint32_t, uint32_t>(a.first, a.second));
-            }
-        } else {
-            // not sparse and not eseq, entire range
-            clearRanges.push_back(std::pair<uint32_t, uint32_t>(0, e->fp->getChannelCount()));
-        }
+        GetEffectRanges(e, [](uint32_t start, uint32_t count) {
+            clearRanges.push_back(std::pair<uint32_t, uint32_t>(start, count));
+        });
     }
     delete e;
     effects[effectID] = NULL;
@@ -345,20 +579,24 @@ int OverlayEffect(int effectID, char* channelData) {
     }
 
     e = effects[effectID];
-    FSEQFile::FrameData* d = e->fp->getFrame(e->currentFrame);
-    if (d == nullptr && e->loop) {
-        e->currentFrame = 0;
-        d = e->fp->getFrame(e->currentFrame);
+    bool ready;
+    FSEQFile::FrameData* d = e->NextFrame(ready);
+    if (!ready) {
+        // still being read/decoded, try again next frame
+        return 1;
     }
-    e->currentFrame++;
     if (d) {
         d->readFrame((uint8_t*)channelData, FPPD_MAX_CHANNELS);
-        delete d;
+        e->ReleaseFrame(d);
+        GetEffectRanges(e, [](uint32_t start, uint32_t count) {
+            channelDataChanges.markDirty(start, count);
+        });
         return 1;
     } else {
         StopEffectHelper(effectID);
         for (auto& rng : clearRanges) {
             memset(&channelData[rng.first], 0, rng.second);
+            channelDataChanges.markDirty(rng.first, rng.second);
         }
         clearRanges.clear();
     }
@@ -378,6 +616,7 @@ int OverlayEffects(char* channelData) {
     // for effects that have been stopped, we need to clear the data
     for (auto& rng : clearRanges) {
         memset(&channelData[rng.first], 0, rng.second);
+        channelDataChanges.markDirty(rng.first, rng.second);
     }
     clearRanges.clear();
 
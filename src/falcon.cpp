@@ -29,8 +29,10 @@
 #include "common.h"
 #include "log.h"
 #include "settings.h"
+#include "channeloutput/ChannelOutputSetup.h"
 #include "channeloutput/channeloutputthread.h"
 #include "commands/Commands.h"
+#include "util/DirtyRanges.h"
 #include "util/SPIUtils.h"
 
 #define FALCON_CFG_FILE_MAX_SIZE 2048
@@ -313,6 +315,7 @@ int FalconPassThroughData(int offset, unsigned char* inBuf, int size) {
     // Pass data on to our regular channel outputs followed by blanking data
     bzero(sequence->m_seqData + offset, 4096);
     memcpy(sequence->m_seqData + offset, inBuf, FALCON_PASSTHROUGH_DATA_SIZE);
+    channelDataChanges.markDirty(offset, 4096);
     sequence->SendSequenceData();
     sequence->SendBlankingData(); // reset data so we don't keep reprogramming
 
@@ -64,6 +64,7 @@
 #include "Plugins.h"
 #include "Scheduler.h"
 #include "Sequence.h"
+#include "SequenceReencoder.h"
 #include "Timers.h"
 #include "Warnings.h"
 #include "command.h"
@@ -287,6 +288,8 @@ static void handleCrash(int s) {
         close(fd);
         free(strs);
     }
+    // make sure the above is in fppd.log before it's zipped up
+    FlushLogs();
     if (crashLog >= 1) {
         std::set<std::string> filenames;
         std::string mediaDir = getFPPMediaDir();
@@ -700,6 +703,7 @@ int main(int argc, char* argv[]) {
     PixelOverlayManager::INSTANCE.Initialize();
     PingManager::INSTANCE.Initialize();
     InitializeChannelOutputs();
+    SequenceReencoder::INSTANCE.Initialize();
     PluginManager::INSTANCE.loadUserPlugins();
 
     InitEffects();
@@ -720,6 +724,7 @@ int main(int argc, char* argv[]) {
 
     CleanupMediaOutput();
     CloseEffects();
+    SequenceReencoder::INSTANCE.Cleanup();
     CloseChannelOutputs();
     PingManager::INSTANCE.Cleanup();
     OutputMonitor::INSTANCE.Cleanup();
@@ -753,6 +758,7 @@ int main(int argc, char* argv[]) {
     if (restartFPPD) {
         LogInfo(VB_GENERAL, "Performing Restart.\n");
         remove(FPP_DIR_MEDIA("/fpp-info.json").c_str());
+        FlushLogs();
 
         if ((Player::INSTANCE.GetStatus() == FPP_STATUS_PLAYLIST_PLAYING) &&
             (Player::INSTANCE.WasScheduled())) {
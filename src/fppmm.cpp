@@ -252,6 +252,15 @@ void DumpMappedBlockInfo(const std::string& blockName) {
     case 3:
         printf("Active (Transparent RGB)\n");
         break;
+    case 4:
+        printf("Active (Additive)\n");
+        break;
+    case 5:
+        printf("Active (Maximum)\n");
+        break;
+    case 6:
+        printf("Active (Alpha Blend)\n");
+        break;
     }
 
     printf("Effect running : ");
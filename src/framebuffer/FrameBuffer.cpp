@@ -157,6 +157,11 @@ int FrameBuffer::FBInit(const Json::Value& config) {
     if (!result)
         return 0;
 
+    m_convertRow = GetFBRowConverter(m_bpp);
+    if (!m_convertRow) {
+        LogWarn(VB_CHANNELOUT, "Do not know how to convert data to %d BPP for %s\n", m_bpp, m_device.c_str());
+    }
+
     if (m_autoSync) {
         m_dirtyPages = new volatile uint8_t[m_pages];
         for (int i = 0; i < m_pages; i++)
@@ -258,49 +263,18 @@ void FrameBuffer::DestroyFrameBuffer(void) {
  *
  */
 void FrameBuffer::FBCopyData(const uint8_t* buffer, int draw) {
-    int drow = 0;
-    const uint8_t* sR = buffer + 0; // Input always RGB
-    const uint8_t* sG = buffer + 1;
-    const uint8_t* sB = buffer + 2;
     uint8_t* ob = m_outputBuffer;
 
-    if (draw && (m_pixelSize = 1)) {
+    if (draw) {
         m_bufferLock.lock();
-        ob = FB_CURRENT_PAGE_PTR;
-    }
-    uint8_t* dR;
-    uint8_t* dG;
-    uint8_t* dB;
-    int add = m_bpp / 8;
-
-    for (int y = 0; y < m_pixelsHigh; y++) {
-        // Output is BGR(A)
-        dB = ob + (drow * m_pixelSize * m_rowStride);
-        dG = dB + 1;
-        dR = dB + 2;
-
-        for (int x = 0; x < m_pixelsWide; x++) {
-            for (int sc = 0; sc < m_pixelSize; sc++) {
-                *dR = *sR;
-                *dG = *sG;
-                *dB = *sB;
-
-                dR += add;
-                dG += add;
-                dB += add;
-            }
-
-            sR += 3;
-            sG += 3;
-            sB += 3;
-        }
-
-        dB = ob + (drow * m_pixelSize * m_rowStride);
-        for (int sc = 1; sc < m_pixelSize; sc++) {
-            memcpy(dB + (sc * m_rowStride), dB, m_rowStride);
+        if (m_pixelSize == 1) {
+            ob = FB_CURRENT_PAGE_PTR;
         }
+    }
 
-        drow++;
+    // Input is always RGB, output is RGB565 or BGR(A) depending on m_bpp
+    if (m_convertRow) {
+        FBConvertRows(m_convertRow, ob, m_rowStride, buffer, m_pixelsWide, m_pixelsHigh, m_pixelSize);
     }
 
     if (draw) {
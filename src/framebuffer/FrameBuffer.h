@@ -19,6 +19,8 @@
 
 #include "../config.h"
 
+#include "FrameBufferConvert.h"
+
 typedef enum {
     IT_Random = -2,
     IT_Default = -1,
@@ -136,6 +138,7 @@ protected:
     int m_pixelSize = 0;
     int m_pixelsWide = 0;
     int m_pixelsHigh = 0;
+    FBRowConverter m_convertRow = nullptr; // picked from m_bpp
 
     ImageTransitionType m_transitionType = IT_Normal;
     volatile ImageTransitionType m_nextTransitionType = IT_Normal;
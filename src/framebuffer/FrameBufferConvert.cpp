@@ -0,0 +1,174 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "FrameBufferConvert.h"
+
+// Reads r, g, b (and one byte past it) as a little endian word, callers
+// make sure the last pixel of a row never uses this.
+static inline uint32_t LoadRGBX(const uint8_t* s) {
+    uint32_t v;
+    memcpy(&v, s, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+static inline uint32_t ToBGRA(uint32_t rgbx) {
+    // bytes r g b x -> b g r 0
+    return __builtin_bswap32(rgbx) >> 8;
+}
+static inline uint32_t ToBGRA(const uint8_t* s) {
+    return s[2] | (s[1] << 8) | (s[0] << 16);
+}
+static inline uint16_t ToRGB565(uint32_t rgbx) {
+    return ((rgbx & 0xF8) << 8) | ((rgbx & 0xFC00) >> 5) | ((rgbx & 0xF80000) >> 19);
+}
+static inline uint16_t ToRGB565(const uint8_t* s) {
+    return ((s[0] & 0xF8) << 8) | ((s[1] & 0xFC) << 3) | (s[2] >> 3);
+}
+
+static void ConvertRowBGRA(uint8_t* dst, const uint8_t* src, int pixels, int pixelSize) {
+    if (pixels <= 0) {
+        return;
+    }
+    int x = 0;
+    if (pixelSize == 1) {
+#if defined(__ARM_NEON)
+        // stop short of the last pixel, it's always done below
+        for (; x + 16 < pixels; x += 16) {
+            uint8x16x3_t s = vld3q_u8(src + x * 3);
+            uint8x16x4_t d;
+            d.val[0] = s.val[2];
+            d.val[1] = s.val[1];
+            d.val[2] = s.val[0];
+            d.val[3] = vdupq_n_u8(0);
+            vst4q_u8(dst + x * 4, d);
+        }
+#endif
+        for (; x < pixels - 1; x++) {
+            uint32_t v = ToBGRA(LoadRGBX(src + x * 3));
+            memcpy(dst + x * 4, &v, 4);
+        }
+    } else {
+        uint32_t* d = (uint32_t*)dst;
+        for (; x < pixels - 1; x++) {
+            uint32_t v = ToBGRA(LoadRGBX(src + x * 3));
+            for (int sc = 0; sc < pixelSize; sc++) {
+                memcpy(d++, &v, 4);
+            }
+        }
+    }
+    // last pixel, can't read past the end of the source
+    uint32_t v = ToBGRA(src + x * 3);
+    for (int sc = 0; sc < pixelSize; sc++) {
+        memcpy(dst + (x * pixelSize + sc) * 4, &v, 4);
+    }
+}
+
+static void ConvertRowBGR(uint8_t* dst, const uint8_t* src, int pixels, int pixelSize) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    if (pixelSize == 1) {
+        for (; x + 16 <= pixels; x += 16) {
+            uint8x16x3_t s = vld3q_u8(src + x * 3);
+            uint8x16_t t = s.val[0];
+            s.val[0] = s.val[2];
+            s.val[2] = t;
+            vst3q_u8(dst + x * 3, s);
+        }
+    }
+#endif
+    uint8_t* d = dst + x * pixelSize * 3;
+    for (; x < pixels; x++) {
+        const uint8_t* s = src + x * 3;
+        for (int sc = 0; sc < pixelSize; sc++) {
+            d[0] = s[2];
+            d[1] = s[1];
+            d[2] = s[0];
+            d += 3;
+        }
+    }
+}
+
+static void ConvertRowRGB565(uint8_t* dst, const uint8_t* src, int pixels, int pixelSize) {
+    if (pixels <= 0) {
+        return;
+    }
+    int x = 0;
+    uint16_t* d = (uint16_t*)dst;
+#if defined(__ARM_NEON)
+    if (pixelSize == 1) {
+        // stop short of the last pixel, it's always done below
+        for (; x + 16 < pixels; x += 16) {
+            uint8x16x3_t s = vld3q_u8(src + x * 3);
+            uint16x8_t lo = vshll_n_u8(vget_low_u8(s.val[0]), 8);
+            lo = vsriq_n_u16(lo, vshll_n_u8(vget_low_u8(s.val[1]), 8), 5);
+            lo = vsriq_n_u16(lo, vshll_n_u8(vget_low_u8(s.val[2]), 8), 11);
+            uint16x8_t hi = vshll_n_u8(vget_high_u8(s.val[0]), 8);
+            hi = vsriq_n_u16(hi, vshll_n_u8(vget_high_u8(s.val[1]), 8), 5);
+            hi = vsriq_n_u16(hi, vshll_n_u8(vget_high_u8(s.val[2]), 8), 11);
+            vst1q_u16(d, lo);
+            vst1q_u16(d + 8, hi);
+            d += 16;
+        }
+    }
+#endif
+    if (pixelSize == 1) {
+        for (; x < pixels - 1; x++) {
+            uint16_t v = ToRGB565(LoadRGBX(src + x * 3));
+            memcpy(d++, &v, 2);
+        }
+    }
+    for (; x < pixels - 1; x++) {
+        uint16_t v = ToRGB565(LoadRGBX(src + x * 3));
+        for (int sc = 0; sc < pixelSize; sc++) {
+            memcpy(d++, &v, 2);
+        }
+    }
+    uint16_t v = ToRGB565(src + x * 3);
+    for (int sc = 0; sc < pixelSize; sc++) {
+        memcpy(d++, &v, 2);
+    }
+}
+
+FBRowConverter GetFBRowConverter(int bpp) {
+    switch (bpp) {
+    case 16:
+        return ConvertRowRGB565;
+    case 24:
+        return ConvertRowBGR;
+    case 32:
+        return ConvertRowBGRA;
+    default:
+        return nullptr;
+    }
+}
+
+void FBConvertRows(FBRowConverter convert, uint8_t* dst, int dstStride, const uint8_t* src,
+                   int rowPixels, int rows, int pixelSize) {
+    for (int y = 0; y < rows; y++) {
+        convert(dst, src, rowPixels, pixelSize);
+        for (int sc = 1; sc < pixelSize; sc++) {
+            memcpy(dst + (sc * dstStride), dst, dstStride);
+        }
+        dst += dstStride * pixelSize;
+        src += rowPixels * 3;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <cstdint>
+
+// Convert a row of RGB pixels into the frame buffer's format, each
+// source pixel is written pixelSize times (nearest neighbour scaling).
+// 16bpp is RGB565, 24bpp is BGR and 32bpp is BGRA with the alpha byte 0.
+typedef void (*FBRowConverter)(uint8_t* dst, const uint8_t* src, int pixels, int pixelSize);
+
+// Returns nullptr for formats that aren't handled
+FBRowConverter GetFBRowConverter(int bpp);
+
+// Converts rows rows of src (rowPixels RGB pixels each) into dst, each row
+// written pixelSize times, dstStride apart.
+void FBConvertRows(FBRowConverter convert, uint8_t* dst, int dstStride, const uint8_t* src,
+                   int rowPixels, int rows, int pixelSize);
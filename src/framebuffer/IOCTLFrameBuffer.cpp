@@ -236,7 +236,11 @@ int IOCTLFrameBuffer::InitializeFrameBuffer() {
         }
     }
 
-    if (m_bpp == 16) {
+    bool standard565 = m_vInfo.red.offset == 11 && m_vInfo.red.length == 5 &&
+                       m_vInfo.green.offset == 5 && m_vInfo.green.length == 6 &&
+                       m_vInfo.blue.offset == 0 && m_vInfo.blue.length == 5;
+    if (m_bpp == 16 && !standard565) {
+        // the common RGB565 layout is converted directly, anything else needs the map
         LogExcess(VB_CHANNELOUT, "Generating RGB565Map for Bitfield offset info:\n");
         LogExcess(VB_CHANNELOUT, " R: %d (%d bits)\n", m_vInfo.red.offset, m_vInfo.red.length);
         LogExcess(VB_CHANNELOUT, " G: %d (%d bits)\n", m_vInfo.green.offset, m_vInfo.green.length);
@@ -323,25 +327,29 @@ void IOCTLFrameBuffer::FBCopyData(const uint8_t* buffer, int draw) {
             ob = m_pageBuffers[m_cPage];
         }
 
-        for (int y = 0; y < m_pixelsHigh; y++) {
-            d = ob + (drow * m_pixelSize * m_rowStride);
-            for (int x = 0; x < m_pixelsWide; x++) {
-                for (int sc = 0; sc < m_pixelSize; sc++) {
-                    *((uint16_t*)d) = m_rgb565map[*sR >> 3][*sG >> 2][*sB >> 3];
-                    d += 2;
+        if (m_rgb565map) {
+            for (int y = 0; y < m_pixelsHigh; y++) {
+                d = ob + (drow * m_pixelSize * m_rowStride);
+                for (int x = 0; x < m_pixelsWide; x++) {
+                    for (int sc = 0; sc < m_pixelSize; sc++) {
+                        *((uint16_t*)d) = m_rgb565map[*sR >> 3][*sG >> 2][*sB >> 3];
+                        d += 2;
+                    }
+
+                    sG += sBpp;
+                    sB += sBpp;
+                    sR += sBpp;
                 }
 
-                sG += sBpp;
-                sB += sBpp;
-                sR += sBpp;
-            }
+                d = ob + (drow * m_pixelSize * m_rowStride);
+                for (int sc = 1; sc < m_pixelSize; sc++) {
+                    memcpy(d + (sc * m_rowStride), d, m_rowStride);
+                }
 
-            d = ob + (drow * m_pixelSize * m_rowStride);
-            for (int sc = 1; sc < m_pixelSize; sc++) {
-                memcpy(d + (sc * m_rowStride), d, m_rowStride);
+                drow++;
             }
-
-            drow++;
+        } else {
+            FBConvertRows(m_convertRow, ob, m_rowStride, buffer, m_pixelsWide, m_pixelsHigh, m_pixelSize);
         }
 
         if (draw) {
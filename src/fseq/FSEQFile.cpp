@@ -2,6 +2,7 @@
 #define _FILE_OFFSET_BITS 64
 #define __STDC_FORMAT_MACROS
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <vector>
@@ -50,6 +51,7 @@ int gettimeofday(struct timeval* tp, struct timezone* tzp) {
 #define fseeko _fseeki64
 
 #else
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <unistd.h>
 #endif
@@ -461,6 +463,165 @@ void FSEQFile::preload(uint64_t pos, uint64_t size) {
 #endif
 }
 
+class FSEQFile::MappedFile {
+public:
+    MappedFile(uint8_t* d, uint64_t l, int f) :
+        data(d),
+        length(l),
+        fd(f) {}
+    ~MappedFile() {
+#ifndef _MSC_VER
+        munmap(data, length);
+        close(fd);
+#endif
+    }
+
+    // Touching a page past the end of the file raises SIGBUS, so if the
+    // file is truncated or rewritten (re-uploaded while playing) the
+    // mapping can no longer be used.
+    bool changed() const {
+#ifndef _MSC_VER
+        struct stat st;
+        return fstat(fd, &st) != 0 || (uint64_t)st.st_size != length;
+#else
+        return false;
+#endif
+    }
+
+    uint8_t* data;
+    uint64_t length;
+    int fd; // our own descriptor, frames can outlive the FSEQFile
+};
+class FSEQFile::MappedRead {
+public:
+    MappedRead(const std::shared_ptr<MappedFile>& f,
+               const std::vector<std::pair<uint32_t, uint32_t>>& r,
+               bool p) :
+        file(f),
+        ranges(r),
+        packed(p) {}
+
+    // keeps the mapping alive as long as any frame references it
+    std::shared_ptr<MappedFile> file;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    // packed - the ranges are stored back to back (sparse fseq)
+    // otherwise the ranges are at their channel offset within the frame
+    bool packed;
+};
+
+class MappedFrameData : public FSEQFile::FrameData {
+public:
+    MappedFrameData(uint32_t frame,
+                    const std::shared_ptr<FSEQFile::MappedRead>& rd,
+                    const uint8_t* data,
+                    uint32_t sz) :
+        FrameData(frame),
+        m_read(rd),
+        m_data(data),
+        m_size(sz) {
+    }
+    virtual ~MappedFrameData() {}
+
+    virtual bool readFrame(uint8_t* data, uint32_t maxChannels) override {
+        if (m_read->file->changed()) {
+            return false;
+        }
+        uint32_t offset = 0;
+        for (auto& rng : m_read->ranges) {
+            if (rng.first >= maxChannels) {
+                // still takes up space in a packed frame
+                offset += rng.second;
+                continue;
+            }
+            uint32_t src = m_read->packed ? offset : rng.first;
+            if (src + rng.second > m_size) {
+                return false;
+            }
+            uint32_t toCopy = std::min(rng.second, maxChannels - rng.first);
+            memcpy(&data[rng.first], &m_data[src], toCopy);
+            offset += rng.second;
+        }
+        return true;
+    }
+
+    std::shared_ptr<FSEQFile::MappedRead> m_read;
+    const uint8_t* m_data;
+    uint32_t m_size;
+};
+
+void FSEQFile::prepareMappedRead(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, bool packed) {
+    m_mappedRead.reset();
+#ifndef _MSC_VER
+    if (!m_seqFile || m_mapFailed || m_seqFileSize == 0) {
+        return;
+    }
+    if (sizeof(void*) < 8 && m_seqFileSize > (512 * 1024 * 1024)) {
+        // don't eat up the address space on 32bit platforms, just use read()
+        m_mapFailed = true;
+        return;
+    }
+    if (!m_mappedFile) {
+        void* d = mmap(nullptr, m_seqFileSize, PROT_READ, MAP_SHARED, fileno(m_seqFile), 0);
+        if (d == MAP_FAILED) {
+            LogDebug(VB_SEQUENCE, "Could not memory map %s, reading frames via read(): %s\n", m_filename.c_str(), strerror(errno));
+            m_mapFailed = true;
+            return;
+        }
+        int fd = dup(fileno(m_seqFile));
+        if (fd < 0) {
+            munmap(d, m_seqFileSize);
+            m_mapFailed = true;
+            return;
+        }
+        madvise(d, m_seqFileSize, MADV_SEQUENTIAL);
+        m_mappedFile = std::make_shared<MappedFile>((uint8_t*)d, m_seqFileSize, fd);
+    }
+    m_mappedRead = std::make_shared<MappedRead>(m_mappedFile, ranges, packed);
+#endif
+}
+
+FrameData* FSEQFile::getMappedFrame(uint32_t frame, uint64_t offset, uint32_t frameSize, FrameData* recycle) {
+    if (!m_mappedRead || (offset + frameSize) > m_mappedFile->length) {
+        return nullptr;
+    }
+    if (m_mappedFile->changed()) {
+        LogWarn(VB_SEQUENCE, "%s changed size while playing, reading frames via read()\n", m_filename.c_str());
+        m_mappedRead.reset();
+        m_mappedFile.reset();
+        m_mapFailed = true;
+        return nullptr;
+    }
+    const uint8_t* fdata = &m_mappedFile->data[offset];
+
+    // Touch each page that will be copied so any disk IO happens here
+    // on the reader thread and not later when the frame is output
+    uint8_t touch = 0;
+    uint32_t poffset = 0;
+    for (auto& rng : m_mappedRead->ranges) {
+        uint32_t start = m_mappedRead->packed ? poffset : rng.first;
+        uint32_t end = std::min(start + rng.second, frameSize);
+        for (uint32_t x = start; x < end; x += 4096) {
+            touch += fdata[x];
+        }
+        if (end > start) {
+            touch += fdata[end - 1];
+        }
+        poffset += rng.second;
+    }
+    m_mappedTouch = touch;
+
+    MappedFrameData* data = dynamic_cast<MappedFrameData*>(recycle);
+    if (data) {
+        data->frame = frame;
+        data->m_read = m_mappedRead;
+        data->m_data = fdata;
+        data->m_size = frameSize;
+        return data;
+    }
+    delete recycle;
+    return new MappedFrameData(frame, m_mappedRead, fdata, frameSize);
+}
+
 inline bool isRecognizedStringVariableHeader(uint8_t a, uint8_t b) {
     // mf - media filename
     // sp - sequence producer
@@ -713,6 +874,21 @@ public:
     std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
 };
 
+// reuses the buffer from recycle if possible, otherwise allocates a new UncompressedFrameData
+static UncompressedFrameData* createUncompressedFrameData(FrameData* recycle,
+                                                          uint32_t frame,
+                                                          uint32_t sz,
+                                                          const std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+    UncompressedFrameData* data = dynamic_cast<UncompressedFrameData*>(recycle);
+    if (data && data->m_size == sz && data->m_data) {
+        data->frame = frame;
+        data->m_ranges = ranges;
+        return data;
+    }
+    delete recycle;
+    return new UncompressedFrameData(frame, sz, ranges);
+}
+
 void V1FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint32_t startFrame) {
     m_rangesToRead = ranges;
     m_dataBlockSize = 0;
@@ -725,13 +901,14 @@ void V1FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>>& r
         }
         m_dataBlockSize += toRead;
     }
+    prepareMappedRead(m_rangesToRead, false);
     FrameData* f = getFrame(startFrame);
     if (f) {
         delete f;
     }
 }
 
-FrameData* V1FSEQFile::getFrame(uint32_t frame) {
+FrameData* V1FSEQFile::getFrame(uint32_t frame, FrameData* recycle) {
     if (m_rangesToRead.empty()) {
         std::vector<std::pair<uint32_t, uint32_t>> range;
         range.push_back(std::pair<uint32_t, uint32_t>(0, m_seqChannelCount));
@@ -741,7 +918,12 @@ FrameData* V1FSEQFile::getFrame(uint32_t frame) {
     offset *= frame;
     offset += m_seqChanDataOffset;
 
-    UncompressedFrameData* data = new UncompressedFrameData(frame, m_dataBlockSize, m_rangesToRead);
+    FrameData* mapped = getMappedFrame(frame, offset, m_seqChannelCount, recycle);
+    if (mapped) {
+        return mapped;
+    }
+
+    UncompressedFrameData* data = createUncompressedFrameData(recycle, frame, m_dataBlockSize, m_rangesToRead);
     if (seek(offset, SEEK_SET)) {
         LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data for frame %d! %" PRIu64 "\n", frame, offset);
         return data;
@@ -786,6 +968,10 @@ static const int V2FSEQ_OUT_BUFFER_SIZE = 8 * 1024 * 1024;       // 8MB output b
 static const int V2FSEQ_OUT_BUFFER_FLUSH_SIZE = 4 * 1024 * 1024; // 50% full, flush it
 static const int V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE = 64 * 1024;  // 64KB blocks
 #endif
+#ifndef NO_ZSTD
+static const int V2FSEQ_MAX_DECODE_THREADS = 4;
+static const uint64_t V2FSEQ_MAX_DECODE_MEMORY = 96 * 1024 * 1024; // decoded blocks held ahead of playback
+#endif
 
 class V2Handler {
 public:
@@ -796,7 +982,7 @@ public:
     virtual ~V2Handler() {}
 
     virtual uint8_t getCompressionType() = 0;
-    virtual FrameData* getFrame(uint32_t frame) = 0;
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) = 0;
 
     virtual uint32_t computeMaxBlocks(int max = 255) { return 0; }
     virtual void addFrame(uint32_t frame, const uint8_t* data) = 0;
@@ -817,6 +1003,9 @@ public:
     void preload(uint64_t pos, uint64_t size) {
         m_file->preload(pos, size);
     }
+    FrameData* getMappedFrame(uint32_t frame, uint64_t offset, uint32_t frameSize, FrameData* recycle) {
+        return m_file->getMappedFrame(frame, offset, frameSize, recycle);
+    }
 
     virtual void prepareRead(uint32_t frame) {}
 
@@ -853,16 +1042,20 @@ public:
     virtual uint8_t getCompressionType() override { return 0; }
     virtual std::string GetType() const override { return "No Compression"; }
     virtual void prepareRead(uint32_t frame) override {
-        FrameData* f = getFrame(frame);
+        FrameData* f = getFrame(frame, nullptr);
         if (f) {
             delete f;
         }
     }
-    virtual FrameData* getFrame(uint32_t frame) override {
-        UncompressedFrameData* data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) override {
         uint64_t offset = m_file->getChannelCount();
         offset *= frame;
         offset += m_seqChanDataOffset;
+        FrameData* mapped = getMappedFrame(frame, offset, m_file->getChannelCount(), recycle);
+        if (mapped) {
+            return mapped;
+        }
+        UncompressedFrameData* data = createUncompressedFrameData(recycle, frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
         if (seek(offset, SEEK_SET)) {
             LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data! %" PRIu64 "\n", offset);
             return data;
@@ -937,7 +1130,8 @@ public:
         uint64_t datasize = m_file->getChannelCount();
         uint64_t numFrames = m_file->getNumFrames();
         datasize *= numFrames;
-        uint64_t numBlocks = datasize / V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+        uint64_t blockSize = m_file->m_compressionBlockSize ? m_file->m_compressionBlockSize : V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+        uint64_t numBlocks = datasize / blockSize;
         if (numBlocks > maxNumBlocks) {
             // need a lot of blocks, use as many as we can
             numBlocks = maxNumBlocks;
@@ -1084,11 +1278,16 @@ public:
             m_readSignal.notify_all();
         }
     }
-    uint8_t* getBlock(int block) {
+    // Decode threads wait for blocks that are still well ahead of playback
+    // and free them themselves once decoded.
+    uint8_t* getBlock(int block, bool fromDecodeThread = false) {
         std::unique_lock<std::mutex> readerlock(m_readMutex);
         uint8_t* data = m_blockMap[block];
         while (data == nullptr) {
-            if ((block > (m_firstBlock + 3)) && m_firstBlock) {
+            if (!m_readThreadRunning) {
+                return nullptr;
+            }
+            if (!fromDecodeThread && (block > (m_firstBlock + 3)) && m_firstBlock) {
                 // if not one of the first few blocks and it's not already
                 // available, then something is really slow
                 AddSlowStorageWarning();
@@ -1096,10 +1295,11 @@ public:
                 LogWarn(VB_SEQUENCE, "Blocks: %d     First: %d\n", m_blocksToRead.size(), m_blocksToRead.empty() ? -1 : m_blocksToRead.front());
             }
             m_blocksToRead.push_front(block);
+            m_readSignal.notify_all();
             m_readSignal.wait_for(readerlock, 10s);
             data = m_blockMap[block];
         }
-        if (block > 2) {
+        if (!fromDecodeThread && block > 2) {
             // clean up old blocks we don't need anymore
             uint8_t* old = m_blockMap[block - 2];
             m_blockMap[block - 2] = nullptr;
@@ -1107,6 +1307,15 @@ public:
         }
         return data;
     }
+    void releaseBlock(int block) {
+        std::unique_lock<std::mutex> readerlock(m_readMutex);
+        m_blocksToRead.remove(block);
+        auto it = m_blockMap.find(block);
+        if (it != m_blockMap.end()) {
+            free(it->second);
+            m_blockMap.erase(it);
+        }
+    }
 
     // for compressed files, this is the compression data
     uint32_t m_framesPerBlock;
@@ -1139,6 +1348,25 @@ public:
         LogDebug(VB_SEQUENCE, "  Prepared to read/write a ZSTD compress fseq file.\n");
     }
     virtual ~V2ZSTDCompressionHandler() {
+        if (!m_decodeThreads.empty()) {
+            std::unique_lock<std::mutex> lock(m_decodeMutex);
+            m_decodeThreadsRunning = false;
+            m_blocksToDecode.clear();
+            lock.unlock();
+            m_decodeSignal.notify_all();
+            m_readSignal.notify_all();
+            for (auto t : m_decodeThreads) {
+                t->join();
+                delete t;
+            }
+            m_decodeThreads.clear();
+        }
+        for (auto& a : m_decodedBlocks) {
+            if (a.second) {
+                free(a.second);
+            }
+        }
+        m_decodedBlocks.clear();
         free(m_outBuffer.dst);
         if (m_cctx) {
             ZSTD_freeCStream(m_cctx);
@@ -1150,7 +1378,167 @@ public:
     virtual uint8_t getCompressionType() override { return 1; }
     virtual std::string GetType() const override { return "Compressed ZSTD"; }
 
-    virtual FrameData* getFrame(uint32_t frame) override {
+    virtual void prepareRead(uint32_t frame) override {
+        V2CompressedHandler::prepareRead(frame);
+
+        // Decode whole blocks ahead of playback on a small pool of threads so the
+        // next block is already decompressed when getFrame crosses into it.
+        // Single core machines keep the original inline streaming decode.
+        int cores = std::thread::hardware_concurrency();
+        int numThreads = std::min(cores - 1, V2FSEQ_MAX_DECODE_THREADS);
+        if (numThreads < 1 || m_file->m_frameOffsets.size() < 3 || !m_decodeThreads.empty()) {
+            return;
+        }
+        uint64_t maxBlockSize = 0;
+        for (int b = 0; b < m_file->m_frameOffsets.size() - 1; b++) {
+            maxBlockSize = std::max(maxBlockSize, getDecodedBlockSize(b));
+        }
+        m_decodeAhead = numThreads;
+        while (m_decodeAhead > 1 && (maxBlockSize * (m_decodeAhead + 1)) > V2FSEQ_MAX_DECODE_MEMORY) {
+            m_decodeAhead--;
+        }
+        LogDebug(VB_SEQUENCE, "Using %d threads to decode %d blocks ahead\n", numThreads, m_decodeAhead);
+        m_decodeThreadsRunning = true;
+        for (int x = 0; x < numThreads; x++) {
+            m_decodeThreads.push_back(new std::thread([this]() {
+                SetThreadName("FSEQDecode");
+                decodeBlocksLoop();
+            }));
+        }
+    }
+
+    uint64_t getDecodedBlockSize(int block) {
+        uint64_t numFrames = (m_file->m_frameOffsets[block + 1].first > m_file->getNumFrames() ? m_file->getNumFrames() : m_file->m_frameOffsets[block + 1].first) - m_file->m_frameOffsets[block].first;
+        return numFrames * m_file->getChannelCount();
+    }
+
+    void decodeBlocksLoop() {
+        ZSTD_DStream* dctx = ZSTD_createDStream();
+        std::unique_lock<std::mutex> lock(m_decodeMutex);
+        while (m_decodeThreadsRunning) {
+            if (m_blocksToDecode.empty()) {
+                m_decodeSignal.wait_for(lock, 25ms);
+                continue;
+            }
+            int block = m_blocksToDecode.front();
+            m_blocksToDecode.pop_front();
+            if (m_decodedBlocks.find(block) != m_decodedBlocks.end()) {
+                // already decoded or another thread is working on it
+                continue;
+            }
+            m_decodedBlocks[block] = nullptr;
+            lock.unlock();
+
+            uint8_t* decoded = nullptr;
+            uint64_t len = m_file->m_frameOffsets[block + 1].second - m_file->m_frameOffsets[block].second;
+            uint64_t max = m_file->getNumFrames() * m_file->getChannelCount();
+            if (len > max) {
+                len = max;
+            }
+            uint8_t* src = getBlock(block, true);
+            if (src) {
+                uint64_t outSize = getDecodedBlockSize(block);
+                decoded = (uint8_t*)malloc(outSize);
+                ZSTD_initDStream(dctx);
+                ZSTD_inBuffer_s input = { src, len, 0 };
+                ZSTD_outBuffer_s output = { decoded, outSize, 0 };
+                while (output.pos < output.size && input.pos < input.size) {
+                    size_t r = ZSTD_decompressStream(dctx, &output, &input);
+                    if (ZSTD_isError(r)) {
+                        LogErr(VB_SEQUENCE, "Error decompressing block %d: %s\n", block, ZSTD_getErrorName(r));
+                        break;
+                    }
+                    if (r == 0) {
+                        break;
+                    }
+                }
+                // the compressed data is no longer needed once decoded
+                releaseBlock(block);
+            }
+
+            lock.lock();
+            if (!decoded || block < m_decodeWindowStart || block > (m_decodeWindowStart + m_decodeAhead)) {
+                // playback moved on (or seeked) while decoding, not needed anymore
+                free(decoded);
+                m_decodedBlocks.erase(block);
+            } else {
+                m_decodedBlocks[block] = decoded;
+            }
+            m_decodedSignal.notify_all();
+        }
+        lock.unlock();
+        ZSTD_freeDStream(dctx);
+    }
+
+    uint8_t* getDecodedBlock(int block) {
+        std::unique_lock<std::mutex> lock(m_decodeMutex);
+        m_decodeWindowStart = block;
+
+        // drop anything outside the new window
+        auto it = m_decodedBlocks.begin();
+        while (it != m_decodedBlocks.end()) {
+            if (it->second && (it->first < block || it->first > (block + m_decodeAhead))) {
+                free(it->second);
+                it = m_decodedBlocks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_blocksToDecode.clear();
+        std::unique_lock<std::mutex> readerlock(m_readMutex);
+        // The compressed data of blocks behind playback (read ahead before a
+        // seek, etc...) isn't needed anymore unless a decode thread is still
+        // working on it.  Decoding blocks in progress are in m_decodedBlocks
+        // as nullptr.
+        m_blocksToRead.remove_if([block](int b) { return b < block; });
+        for (auto rb = m_blockMap.begin(); rb != m_blockMap.end() && rb->first < block;) {
+            auto d = m_decodedBlocks.find(rb->first);
+            if (d != m_decodedBlocks.end() && d->second == nullptr) {
+                ++rb;
+            } else {
+                free(rb->second);
+                rb = m_blockMap.erase(rb);
+            }
+        }
+        int lastBlock = m_file->m_frameOffsets.size() - 2;
+        for (int b = block; b <= std::min(block + m_decodeAhead, lastBlock); b++) {
+            if (m_decodedBlocks.find(b) == m_decodedBlocks.end()) {
+                m_blocksToDecode.push_back(b);
+                auto rb = m_blockMap.find(b);
+                if ((rb == m_blockMap.end() || rb->second == nullptr) &&
+                    std::find(m_blocksToRead.begin(), m_blocksToRead.end(), b) == m_blocksToRead.end()) {
+                    // have the read thread fetch it before a decode thread
+                    // asks for it
+                    uint64_t pos = m_file->m_frameOffsets[b].second;
+                    preload(pos, m_file->m_frameOffsets[b + 1].second - pos);
+                    m_blocksToRead.push_back(b);
+                }
+            }
+        }
+        readerlock.unlock();
+        m_readSignal.notify_all();
+        m_decodeSignal.notify_all();
+
+        auto f = m_decodedBlocks.find(block);
+        while (f == m_decodedBlocks.end() || f->second == nullptr) {
+            if (!m_decodeThreadsRunning) {
+                return nullptr;
+            }
+            if (f == m_decodedBlocks.end() && std::find(m_blocksToDecode.begin(), m_blocksToDecode.end(), block) == m_blocksToDecode.end()) {
+                // a decode thread dropped it, request it again
+                m_blocksToDecode.push_front(block);
+                m_decodeSignal.notify_all();
+            }
+            m_decodedSignal.wait_for(lock, 25ms);
+            f = m_decodedBlocks.find(block);
+        }
+        return f->second;
+    }
+
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) override {
+        if (!m_decodeThreads.empty()) {
+            return getFrameFromDecodedBlock(frame, recycle);
+        }
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             // frame is not in the current block
             m_curBlock = 0;
@@ -1195,7 +1583,7 @@ public:
 
         fidx *= m_file->getChannelCount();
         uint8_t* fdata = (uint8_t*)m_outBuffer.dst;
-        UncompressedFrameData* data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        UncompressedFrameData* data = createUncompressedFrameData(recycle, frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
 
         // This stops the crash on load ... but it is not the root cause.
         // But better to not load completely than crashing
@@ -1204,21 +1592,41 @@ public:
             LogErr(VB_SEQUENCE, "Frame index calculated as a negative number. Aborting frame %d load.\n", (int)frame);
             return data;
         }
-
+        copyFrameData(data, &fdata[fidx]);
+        return data;
+    }
+    FrameData* getFrameFromDecodedBlock(uint32_t frame, FrameData* recycle) {
+        if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
+            // frame is not in the current block
+            m_curBlock = 0;
+            while (frame >= m_file->m_frameOffsets[m_curBlock + 1].first) {
+                m_curBlock++;
+            }
+            m_curBlockData = getDecodedBlock(m_curBlock);
+        }
+        UncompressedFrameData* data = createUncompressedFrameData(recycle, frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        if (m_curBlockData == nullptr) {
+            LogErr(VB_SEQUENCE, "Block %d could not be decoded. Aborting frame %d load.\n", m_curBlock, (int)frame);
+            return data;
+        }
+        uint64_t fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
+        fidx *= m_file->getChannelCount();
+        copyFrameData(data, &m_curBlockData[fidx]);
+        return data;
+    }
+    void copyFrameData(UncompressedFrameData* data, const uint8_t* fdata) {
         if (!m_file->m_sparseRanges.empty()) {
-            memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
+            memcpy(data->m_data, fdata, m_file->getChannelCount());
         } else {
             uint32_t sz = 0;
             // read the ranges into the buffer
             for (auto& rng : data->m_ranges) {
                 if (rng.first < m_file->getChannelCount()) {
-                    uint64_t start = fidx + rng.first;
-                    memcpy(&data->m_data[sz], &fdata[start], rng.second);
+                    memcpy(&data->m_data[sz], &fdata[rng.first], rng.second);
                     sz += rng.second;
                 }
             }
         }
-        return data;
     }
     void compressData(ZSTD_CStream* m_cctx, ZSTD_inBuffer_s& input, ZSTD_outBuffer_s& output) {
         ZSTD_compressStream2(m_cctx, &output, &input, ZSTD_e_continue);
@@ -1330,6 +1738,18 @@ public:
     ZSTD_DStream* m_dctx = nullptr;
     ZSTD_outBuffer_s m_outBuffer;
     ZSTD_inBuffer_s m_inBuffer;
+
+    // multi-block decode pipeline
+    std::vector<std::thread*> m_decodeThreads;
+    std::atomic_bool m_decodeThreadsRunning = false;
+    std::mutex m_decodeMutex;
+    std::condition_variable m_decodeSignal;
+    std::condition_variable m_decodedSignal;
+    std::list<int> m_blocksToDecode;
+    std::map<int, uint8_t*> m_decodedBlocks;
+    int m_decodeWindowStart = 0;
+    int m_decodeAhead = 0;
+    uint8_t* m_curBlockData = nullptr;
 };
 #endif
 
@@ -1350,7 +1770,7 @@ public:
     virtual uint8_t getCompressionType() override { return 2; }
     virtual std::string GetType() const override { return "Compressed ZLIB"; }
 
-    virtual FrameData* getFrame(uint32_t frame) override {
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) override {
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             // frame is not in the current block
             m_curBlock = 0;
@@ -1390,7 +1810,7 @@ public:
         int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
         fidx *= m_file->getChannelCount();
         uint8_t* fdata = (uint8_t*)m_outBuffer;
-        UncompressedFrameData* data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        UncompressedFrameData* data = createUncompressedFrameData(recycle, frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
         if (!m_file->m_sparseRanges.empty()) {
             memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
         } else {
@@ -1896,27 +2316,28 @@ void V2FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>>& r
             LogErr(VB_SEQUENCE, "Requested ouput range outside read ranges. Requested %d channels starting at %d\n", cnt, st);
         }
     }
+    if (m_compressionType == CompressionType::none) {
+        prepareMappedRead(m_rangesToRead, !m_sparseRanges.empty());
+    }
     m_handler->prepareRead(startFrame);
 }
-FrameData* V2FSEQFile::getFrame(uint32_t frame) {
+FrameData* V2FSEQFile::getFrame(uint32_t frame, FrameData* recycle) {
     if (m_rangesToRead.empty()) {
         std::vector<std::pair<uint32_t, uint32_t>> range;
         range.push_back(std::pair<uint32_t, uint32_t>(0, getMaxChannel()));
         prepareRead(range, frame);
     }
-    if (frame >= m_seqNumFrames) {
+    if (frame >= m_seqNumFrames || m_handler == nullptr) {
+        delete recycle;
         return nullptr;
     }
-    if (m_handler != nullptr) {
-        FrameData* fd = nullptr;
-        try {
-            fd = m_handler->getFrame(frame);
-        } catch (...) {
-            LogErr(VB_SEQUENCE, "Error getting frame from handler %s.\n", m_handler->GetType().c_str());
-        }
-        return fd;
+    FrameData* fd = nullptr;
+    try {
+        fd = m_handler->getFrame(frame, recycle);
+    } catch (...) {
+        LogErr(VB_SEQUENCE, "Error getting frame from handler %s.\n", m_handler->GetType().c_str());
     }
-    return nullptr;
+    return fd;
 }
 void V2FSEQFile::addFrame(uint32_t frame,
                           const uint8_t* data) {
@@ -1942,3 +2363,159 @@ uint32_t V2FSEQFile::getMaxChannel() const {
     }
     return ret;
 }
+
+#ifndef NO_ZSTD
+// The largest block that one core decompresses in half a frame, times the
+// number of threads that decode blocks ahead during playback, limited to
+// what those threads are allowed to hold.  The speed is measured on a
+// sample of the actual data from the middle of the sequence.
+static uint32_t computeReencodeBlockSize(const std::string& srcName,
+                                         const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+                                         uint32_t frameSize,
+                                         uint32_t maxChannel) {
+    std::unique_ptr<FSEQFile> src(FSEQFile::openFSEQFile(srcName));
+    if (!src || src->getNumFrames() == 0) {
+        return V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+    }
+    uint32_t numFrames = std::min(src->getNumFrames(), std::max(1U, (4U * 1024 * 1024) / frameSize));
+    numFrames = std::min(numFrames, 100U);
+    uint32_t start = (src->getNumFrames() - numFrames) / 2;
+    src->prepareRead(ranges, start);
+
+    std::vector<uint8_t> frame(maxChannel);
+    std::vector<uint8_t> sample;
+    sample.reserve((size_t)numFrames * frameSize);
+    FrameData* fd = nullptr;
+    for (uint32_t f = start; f < start + numFrames; f++) {
+        fd = src->getFrame(f, fd);
+        if (fd == nullptr) {
+            break;
+        }
+        fd->readFrame(&frame[0], maxChannel);
+        for (auto& rng : ranges) {
+            sample.insert(sample.end(), &frame[rng.first], &frame[rng.first] + rng.second);
+        }
+    }
+    delete fd;
+    if (sample.empty()) {
+        return V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+    }
+
+    std::vector<uint8_t> compressed(ZSTD_compressBound(sample.size()));
+    size_t csize = ZSTD_compress(&compressed[0], compressed.size(), &sample[0], sample.size(), 2);
+    if (ZSTD_isError(csize)) {
+        return V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    uint64_t us = 0;
+    while (us < 20000) {
+        size_t r = ZSTD_decompress(&sample[0], sample.size(), &compressed[0], csize);
+        if (ZSTD_isError(r)) {
+            return V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE;
+        }
+        bytes += r;
+        us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    int threads = std::max(1, std::min((int)std::thread::hardware_concurrency() - 1, V2FSEQ_MAX_DECODE_THREADS));
+    uint64_t blockSize = bytes * src->getStepTime() * 1000 / 2 / us * threads;
+    blockSize = std::min(blockSize, V2FSEQ_MAX_DECODE_MEMORY / (threads + 1));
+    blockSize = std::max(blockSize, (uint64_t)V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE);
+    LogDebug(VB_SEQUENCE, "Decompressed %" PRIu64 " bytes in %" PRIu64 "us, using %" PRIu64 " byte blocks\n", bytes, us, blockSize);
+    return blockSize;
+}
+#endif
+
+bool FSEQFile::reencodeFSEQFile(const std::string& srcName,
+                                const std::string& destName,
+                                const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+                                uint32_t blockSize,
+                                const std::vector<VariableHeader>& extraHeaders,
+                                const std::function<bool()>& cancelled) {
+#ifdef NO_ZSTD
+    LogErr(VB_SEQUENCE, "No support for zstd compression\n");
+    return false;
+#else
+    std::unique_ptr<FSEQFile> src(openFSEQFile(srcName));
+    if (!src) {
+        return false;
+    }
+
+    // sorted, merged and limited to the channels the source has
+    uint32_t maxChannel = src->getMaxChannel();
+    std::vector<std::pair<uint32_t, uint32_t>> sorted = ranges;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::pair<uint32_t, uint32_t>> keep;
+    for (auto rng : sorted) {
+        if (rng.first >= maxChannel || rng.second == 0) {
+            continue;
+        }
+        rng.second = std::min(rng.second, maxChannel - rng.first);
+        if (!keep.empty() && rng.first <= keep.back().first + keep.back().second) {
+            uint32_t end = std::max(keep.back().first + keep.back().second, rng.first + rng.second);
+            keep.back().second = end - keep.back().first;
+        } else {
+            keep.push_back(rng);
+        }
+    }
+    if (keep.empty()) {
+        LogErr(VB_SEQUENCE, "None of the channels to keep are in %s\n", srcName.c_str());
+        return false;
+    }
+    uint32_t frameSize = 0;
+    for (auto& rng : keep) {
+        frameSize += rng.second;
+    }
+    if (blockSize == 0) {
+        blockSize = computeReencodeBlockSize(srcName, keep, frameSize, maxChannel);
+    }
+
+    std::string tmpName = destName + ".tmp";
+    std::unique_ptr<V2FSEQFile> dest((V2FSEQFile*)createFSEQFile(tmpName, V2FSEQ_MAJOR_VERSION, CompressionType::zstd, -99));
+    if (!dest) {
+        return false;
+    }
+    // small blocks on long sequences need more than 255 of them
+    dest->enableMinorVersionFeatures(1);
+    dest->initializeFromFSEQ(*src);
+    for (auto& h : extraHeaders) {
+        dest->addVariableHeader(h);
+    }
+    dest->m_sparseRanges = keep;
+    dest->m_compressionBlockSize = blockSize;
+    dest->writeHeader();
+
+    src->prepareRead(keep);
+    std::vector<uint8_t> data(maxChannel);
+    FrameData* fd = nullptr;
+    bool ok = true;
+    for (uint32_t f = 0; f < src->getNumFrames(); f++) {
+        if (cancelled && cancelled()) {
+            LogDebug(VB_SEQUENCE, "Re-encoding %s cancelled\n", srcName.c_str());
+            ok = false;
+            break;
+        }
+        fd = src->getFrame(f, fd);
+        if (fd == nullptr || !fd->readFrame(&data[0], maxChannel)) {
+            LogErr(VB_SEQUENCE, "Could not read frame %d of %s\n", f, srcName.c_str());
+            ok = false;
+            break;
+        }
+        dest->addFrame(f, &data[0]);
+    }
+    delete fd;
+    if (ok) {
+        dest->finalize();
+    }
+    dest.reset();
+
+    if (!ok || rename(tmpName.c_str(), destName.c_str()) != 0) {
+        remove(tmpName.c_str());
+        return false;
+    }
+    LogDebug(VB_SEQUENCE, "Re-encoded %s to %s, %d of %d channels, %d byte blocks\n",
+             srcName.c_str(), destName.c_str(), frameSize, src->getChannelCount(), blockSize);
+    return true;
+#endif
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stdio.h>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -101,6 +103,18 @@ public:
                                     int version,
                                     CompressionType ct = CompressionType::zstd,
                                     int level = -99);
+
+    // Re-encode just the channels in ranges of src to a zstd compressed
+    // sparse v2 fseq.  blockSize is the uncompressed size of each compression
+    // block, 0 picks one for how fast this machine decompresses the data.
+    // The new file is written next to dest and renamed over it when complete.
+    // If cancelled returns true (checked every frame) nothing is written.
+    static bool reencodeFSEQFile(const std::string& src,
+                                 const std::string& dest,
+                                 const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+                                 uint32_t blockSize = 0,
+                                 const std::vector<VariableHeader>& extraHeaders = {},
+                                 const std::function<bool()>& cancelled = nullptr);
     // utility methods
     static std::string getMediaFilename(const std::string& fn);
     std::string getMediaFilename() const;
@@ -116,7 +130,12 @@ public:
     // For reading data from the fseq file, returns an object can
     // provide the necessary data in a timely fashion for the given frame
     // It may not be used right away and will be deleted at some point in the future
-    virtual FrameData* getFrame(uint32_t frame) = 0;
+    FrameData* getFrame(uint32_t frame) { return getFrame(frame, nullptr); }
+
+    // Same as above, but a FrameData previously returned from getFrame can be
+    // passed in to be refilled instead of allocating a new one.  The file
+    // takes ownership of recycle, it is either returned or deleted.
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) = 0;
 
     // For writing to the fseq file
     virtual void enableMinorVersionFeatures(uint8_t ver) {}
@@ -168,10 +187,24 @@ protected:
     uint64_t read(void* ptr, uint64_t size);
     void preload(uint64_t pos, uint64_t size);
 
+    // Uncompressed channel data can be read directly out of a memory
+    // mapping of the file instead of into a per frame buffer.
+    // getMappedFrame returns nullptr if mapping is not available.
+    void prepareMappedRead(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, bool packed);
+    FrameData* getMappedFrame(uint32_t frame, uint64_t offset, uint32_t frameSize, FrameData* recycle);
+
 private:
     FILE* volatile m_seqFile;
     std::vector<uint8_t> m_memoryBuffer;
     uint64_t m_memoryBufferPos;
+
+    class MappedFile;
+    class MappedRead;
+    std::shared_ptr<MappedFile> m_mappedFile;
+    std::shared_ptr<MappedRead> m_mappedRead;
+    bool m_mapFailed = false;
+    volatile uint8_t m_mappedTouch = 0;
+    friend class MappedFrameData;
 };
 
 class V1FSEQFile : public FSEQFile {
@@ -182,7 +215,8 @@ public:
     virtual ~V1FSEQFile();
 
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint32_t startFrame = 0) override;
-    virtual FrameData* getFrame(uint32_t frame) override;
+    using FSEQFile::getFrame;
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) override;
 
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -206,7 +240,8 @@ public:
     virtual ~V2FSEQFile();
 
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint32_t startFrame = 0) override;
-    virtual FrameData* getFrame(uint32_t frame) override;
+    using FSEQFile::getFrame;
+    virtual FrameData* getFrame(uint32_t frame, FrameData* recycle) override;
 
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -238,6 +273,7 @@ public:
     std::vector<std::pair<uint32_t, uint64_t>> m_frameOffsets;
     uint32_t m_dataBlockSize;
     bool m_allowExtendedBlocks;
+    uint32_t m_compressionBlockSize = 0; // target uncompressed bytes per block when writing, 0 for the default
 
 private:
     void createHandler();
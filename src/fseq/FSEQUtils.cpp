@@ -29,12 +29,16 @@ void usage(char* appname) {
     printf("   -f #              - FSEQ Version\n");
     printf("   -c (none|zstd|zlib) - Compession type\n");
     printf("   -l #              - Compression level (-99 for default)\n");
+    printf("   -b #              - Compression block size in KB (0 for default)\n");
     printf("   -r (#-# | #+#)    - Channel Range.  Use - to separate start/end channel\n");
     printf("                            Use + to separate start channel + num channels\n");
     printf("                       If used before first -m/-M argument, sets a sparse range of output\n");
     printf("                       If used after -m/-M argument, sets a range to read from last merged sequence.\n");
     printf("                       If used before -d argument, sets the range to dump.\n");
     printf("   -n                - No Sparse. -r will only read the range, but the resulting fseq is not sparse.\n");
+    printf("   -O                - Re-encode the input to OUTPUTFILE keeping only the -r ranges.  The block\n");
+    printf("                       size is tuned for this machine unless -b is given.  OUTPUTFILE is\n");
+    printf("                       replaced only once the new file is complete.\n");
     printf("   -j                - Output the fseq file metadata to json\n");
     printf("   -d                - Dump the fseq data to stdout in human-readable format\n");
     printf("   -h                - This help output\n");
@@ -57,6 +61,8 @@ static std::list<MergeFSEQ> mergeFseqs;
 static int fseqMajVersion = 2;
 static int fseqMinVersion = 0;
 static int compressionLevel = -99;
+static uint32_t blockSize = 0;
+static bool reencode = false;
 static bool verbose = false;
 static std::vector<std::pair<uint32_t, uint32_t>> ranges;
 static bool sparse = true;
@@ -91,7 +97,7 @@ int parseArguments(int argc, char** argv) {
             { 0, 0, 0, 0 }
         };
 
-        c = getopt_long(argc, argv, "c:l:o:f:r:m:M:hdjVvn", long_options, &option_index);
+        c = getopt_long(argc, argv, "c:l:b:o:f:r:m:M:hdjVvnO", long_options, &option_index);
         if (c == -1) {
             break;
         }
@@ -128,6 +134,12 @@ int parseArguments(int argc, char** argv) {
         case 'l':
             compressionLevel = strtol(optarg, NULL, 10);
             break;
+        case 'b':
+            blockSize = strtol(optarg, NULL, 10) * 1024;
+            break;
+        case 'O':
+            reencode = true;
+            break;
         case 'f': {
             char* next = nullptr;
             fseqMajVersion = strtol(optarg, &next, 10);
@@ -279,6 +291,15 @@ int main(int argc, char* argv[]) {
                     HexDump(title, data + r.first, r.second, VB_SEQUENCE, 16);
                 }
             }
+        } else if (reencode) {
+            if (outputFilename == nullptr || ranges.empty()) {
+                printf("Re-encoding needs an output file and channel ranges\n");
+                delete src;
+                return 1;
+            }
+            std::string srcName = src->getFilename();
+            delete src;
+            return FSEQFile::reencodeFSEQFile(srcName, outputFilename, ranges, blockSize) ? 0 : 1;
         } else {
             for (auto& f : mergeFseqs) {
                 FSEQFile* src = FSEQFile::openFSEQFile(f.filename);
@@ -309,6 +330,9 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
             dest->enableMinorVersionFeatures(fseqMinVersion);
+            if (fseqMajVersion == 2) {
+                ((V2FSEQFile*)dest)->m_compressionBlockSize = blockSize;
+            }
 
             if (ranges.empty()) {
                 ranges.push_back(std::pair<uint32_t, uint32_t>(0, 999999999));
@@ -195,6 +195,10 @@ void GetCurrentFPPDStatus(Json::Value& result) {
         result["MQTT"]["connected"] = mqtt->IsConnected();
     }
 
+    if (sequence) {
+        sequence->GetStats(result["sequenceStats"]);
+    }
+
     if (getFPPmode() == REMOTE_MODE) {
         int secsElapsed = 0;
         int secsRemaining = 0;
@@ -417,6 +421,9 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PlayerResource::r
         SetOKResult(result, "");
     } else if (url == "sequence") {
         LogDebug(VB_HTTP, "API - Getting list of running sequences\n");
+    } else if (url == "timing") {
+        GetOutputTimingStats(result);
+        SetOKResult(result, "");
     } else if (url == "mqtt/cache") {
         LogDebug(VB_HTTP, "API - Getting MQTT Cached data\n");
         if (mqtt) {
@@ -603,6 +610,9 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PlayerResource::r
         LogDebug(VB_HTTP, "Resetting E131 Statistics");
         ResetBytesReceived();
         SetOKResult(result, "Stats Cleared");
+    } else if (url == "timing") {
+        ResetOutputTimingStats();
+        SetOKResult(result, "Stats Cleared");
     } else {
         LogErr(VB_HTTP, "API - Error unknown DELETE request: %s\n", url.c_str());
 
@@ -13,15 +13,23 @@
 #include "fpp-pch.h"
 
 #include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <thread>
 #include <time.h>
 #include <unistd.h>
 
+#include "common.h"
 #include "fppversion.h"
 #include "log.h"
 
@@ -173,79 +181,411 @@ bool WillLog(int level, FPPLoggerInstance& facility) {
     return true;
 }
 
-void _LogWrite(const char* file, int line, int level, FPPLoggerInstance& facility, const std::string& str, ...) {
-    if (!(WillLog(level, facility)))
+/*
+ * Log lines are formatted on the calling thread into a ring owned by that
+ * thread and written out by the FPP-Log thread, so logging from the output
+ * or sequence reader threads never waits on the log file.  If a ring fills
+ * up the line is dropped and counted, the writer reports the count.
+ */
+#define LOG_RECORD_SIZE 512
+#define LOG_RING_RECORDS 128 // must be a power of 2
+
+class LogRecord {
+public:
+    uint64_t timeUS = 0;
+    int len = 0;
+    std::string* longLine = nullptr; // set if it didn't fit in line
+    char line[LOG_RECORD_SIZE];
+};
+
+// single producer (the owning thread), single consumer (the writer)
+class LogRing {
+public:
+    LogRecord* beginWrite() {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == LOG_RING_RECORDS) {
+            return nullptr;
+        }
+        return &m_records[head & (LOG_RING_RECORDS - 1)];
+    }
+    // returns the number of records now waiting
+    size_t commitWrite() {
+        size_t head = m_head.load(std::memory_order_relaxed) + 1;
+        m_head.store(head, std::memory_order_release);
+        return head - m_tail.load(std::memory_order_relaxed);
+    }
+
+    LogRecord m_records[LOG_RING_RECORDS];
+    alignas(64) std::atomic<size_t> m_head = 0;
+    alignas(64) std::atomic<size_t> m_tail = 0;
+    std::atomic_bool m_orphaned = false; // owning thread has exited
+};
+
+class LogWriter {
+public:
+    LogWriter();
+
+    LogRing* GetThreadRing();
+    void Wake();
+    void Stop();
+    bool Flush(int timeoutMS);
+
+    void WriteLine(const char* line, int len);
+
+    std::atomic_bool m_stopped = false;
+    std::atomic_uint64_t m_dropped = 0;
+    std::timed_mutex m_writeLock; // held while draining rings and writing
+    std::mutex m_ringsLock;
+
+    // Called with m_writeLock held
+    void Drain(bool ringsLocked = false);
+
+private:
+    void Run();
+    void CheckLogFile();
+
+    std::vector<LogRing*> m_rings;
+    std::vector<std::pair<uint64_t, LogRecord*>> m_batch;
+    std::vector<std::pair<LogRing*, size_t>> m_batchHeads;
+    uint64_t m_droppedReported = 0;
+
+    FILE* m_logFile = nullptr;
+    std::string m_logFileName;
+    ino_t m_logFileInode = 0;
+    uint64_t m_nextLogFileCheck = 0;
+
+    std::mutex m_wakeLock;
+    std::condition_variable m_wakeSignal;
+    std::thread* m_thread = nullptr;
+};
+
+class ThreadLogRing {
+public:
+    ~ThreadLogRing() {
+        if (ring) {
+            ring->m_orphaned = true;
+        }
+        ring = nullptr;
+        exited = true;
+    }
+    LogRing* ring = nullptr;
+    bool exited = false;
+    uint64_t tid = 0;
+};
+
+static std::atomic<LogWriter*> logWriter = nullptr;
+static std::mutex logWriterLock;
+static thread_local ThreadLogRing threadLogRing;
+
+static void StopLogWriter() {
+    LogWriter* w = logWriter.load();
+    if (w) {
+        w->Stop();
+    }
+}
+
+// fork() only copies the calling thread, flush everything out and give the
+// child a new writer with nothing outstanding
+static void LogWriterPrepareFork() {
+    LogWriter* w = logWriter.load();
+    if (w) {
+        w->m_writeLock.lock();
+        w->m_ringsLock.lock();
+        w->Drain(true);
+    }
+}
+static void LogWriterParentFork() {
+    LogWriter* w = logWriter.load();
+    if (w) {
+        w->m_ringsLock.unlock();
+        w->m_writeLock.unlock();
+    }
+}
+static void LogWriterChildFork() {
+    // old writer is leaked, its locks are held and its thread doesn't exist here
+    logWriter = nullptr;
+    threadLogRing.ring = nullptr;
+    threadLogRing.tid = 0;
+}
+
+static LogWriter* GetLogWriter() {
+    LogWriter* w = logWriter.load(std::memory_order_acquire);
+    if (!w) {
+        std::unique_lock<std::mutex> lock(logWriterLock);
+        w = logWriter.load();
+        if (!w) {
+            static bool registered = false;
+            if (!registered) {
+                registered = true;
+                atexit(StopLogWriter);
+                pthread_atfork(LogWriterPrepareFork, LogWriterParentFork, LogWriterChildFork);
+            }
+            w = new LogWriter();
+            logWriter.store(w, std::memory_order_release);
+        }
+    }
+    return w;
+}
+
+LogWriter::LogWriter() {
+    m_thread = new std::thread([this]() {
+        SetThreadName("FPP-Log");
+        Run();
+    });
+}
+
+LogRing* LogWriter::GetThreadRing() {
+    if (!threadLogRing.ring && !threadLogRing.exited) {
+        threadLogRing.ring = new LogRing();
+        std::unique_lock<std::mutex> lock(m_ringsLock);
+        m_rings.push_back(threadLogRing.ring);
+    }
+    return threadLogRing.ring;
+}
+
+void LogWriter::Wake() {
+    m_wakeSignal.notify_one();
+}
+
+void LogWriter::Run() {
+    while (!m_stopped) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            m_wakeSignal.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        std::unique_lock<std::timed_mutex> lock(m_writeLock);
+        Drain();
+    }
+}
+
+void LogWriter::Stop() {
+    if (m_stopped.exchange(true)) {
         return;
-    _LogWrite(file, line, level, facility, str.c_str());
+    }
+    Wake();
+    m_thread->join();
+
+    // anything logged from here on is written directly
+    std::unique_lock<std::timed_mutex> lock(m_writeLock);
+    Drain();
 }
 
-void _LogWrite(const char* file, int line, int level, FPPLoggerInstance& facility, const char* format, ...) {
-    // Don't log if we're not concerned about anything at this level
-    if (!(WillLog(level, facility)))
+// Write out everything outstanding from the calling thread.  This is safe
+// to call from a crash handler, if the writer can't be locked in time
+// nothing is written.
+bool LogWriter::Flush(int timeoutMS) {
+    std::unique_lock<std::timed_mutex> lock(m_writeLock, std::chrono::milliseconds(timeoutMS));
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    Drain();
+    return true;
+}
+
+void LogWriter::CheckLogFile() {
+    uint64_t now = GetTimeMS();
+    if (m_logFile && (m_logFileName == logFileName) && (now < m_nextLogFileCheck)) {
         return;
+    }
+    m_nextLogFileCheck = now + 1000;
 
-    va_list arg;
+    // reopen if the file name changed or the file was rotated out from under us
+    struct stat st;
+    if (m_logFile && (m_logFileName == logFileName) &&
+        (stat(logFileName, &st) == 0) && (st.st_ino == m_logFileInode)) {
+        return;
+    }
+    if (m_logFile) {
+        fclose(m_logFile);
+        m_logFile = nullptr;
+    }
+    m_logFileName = logFileName;
+    m_logFile = fopen(m_logFileName.c_str(), "a");
+    if (!m_logFile) {
+        fprintf(stderr, "Error: Unable to open log file for writing!\n");
+        return;
+    }
+    fstat(fileno(m_logFile), &st);
+    m_logFileInode = st.st_ino;
+}
 
+void LogWriter::WriteLine(const char* line, int len) {
+    if (logFileName[0]) {
+        FILE* logFile;
+        if (!strcmp(logFileName, "stderr")) {
+            logFile = stderr;
+        } else if (!strcmp(logFileName, "stdout")) {
+            logFile = stdout;
+        } else {
+            CheckLogFile();
+            logFile = m_logFile ? m_logFile : stderr;
+        }
+        fwrite(line, 1, len, logFile);
+    }
+    if (strcmp(logFileName, "stdout") && logToStdOut) {
+        fwrite(line, 1, len, stdout);
+    }
+}
+
+static void FormatLogRecord(LogRecord* r, const char* file, int line, FPPLoggerInstance& facility,
+                            const char* format, va_list arg) {
     struct timeval tv;
     gettimeofday(&tv, nullptr);
 
     struct tm tm;
-    char timeStr[512];
-
     localtime_r(&tv.tv_sec, &tm);
     int ms = tv.tv_usec / 1000;
 
-    uint64_t tid;
+    uint64_t tid = threadLogRing.tid;
+    if (!tid) {
 #ifdef PLATFORM_OSX
-    pthread_threadid_np(NULL, &tid);
+        pthread_threadid_np(NULL, &tid);
 #else
-    tid = gettid();
+        tid = gettid();
 #endif
-    int size = snprintf(timeStr, sizeof(timeStr),
-                        "%4d-%.2d-%.2d %.2d:%.2d:%.2d.%.3d (%llu) [%s] %s:%d: %s",
-                        1900 + tm.tm_year,
-                        tm.tm_mon + 1,
-                        tm.tm_mday,
-                        tm.tm_hour,
-                        tm.tm_min,
-                        tm.tm_sec,
-                        ms,
-                        tid, facility.name.c_str(), file, line, format);
+        threadLogRing.tid = tid;
+    }
+    int len = snprintf(r->line, LOG_RECORD_SIZE,
+                       "%4d-%.2d-%.2d %.2d:%.2d:%.2d.%.3d (%llu) [%s] %s:%d: ",
+                       1900 + tm.tm_year,
+                       tm.tm_mon + 1,
+                       tm.tm_mday,
+                       tm.tm_hour,
+                       tm.tm_min,
+                       tm.tm_sec,
+                       ms,
+                       tid, facility.name.c_str(), file, line);
+    if (len >= LOG_RECORD_SIZE) {
+        len = LOG_RECORD_SIZE - 1;
+    }
 
-    if (logFileName[0]) {
-        FILE* logFile;
+    va_list arg2;
+    va_copy(arg2, arg);
+    int msgLen = vsnprintf(r->line + len, LOG_RECORD_SIZE - len, format, arg);
+    if (msgLen >= LOG_RECORD_SIZE - len) {
+        r->longLine = new std::string(r->line, len);
+        r->longLine->resize(len + msgLen + 1);
+        vsnprintf(&(*r->longLine)[len], msgLen + 1, format, arg2);
+        r->longLine->resize(len + msgLen);
+    }
+    va_end(arg2);
 
-        bool close = true;
-        if (!strcmp(logFileName, "stderr")) {
-            logFile = stderr;
-            close = false;
-        } else if (!strcmp(logFileName, "stdout")) {
-            logFile = stdout;
-            close = false;
+    r->timeUS = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    r->len = msgLen > 0 ? len + msgLen : len;
+}
+
+void LogWriter::Drain(bool ringsLocked) {
+    m_batch.clear();
+    m_batchHeads.clear();
+
+    std::unique_lock<std::mutex> lock(m_ringsLock, std::defer_lock);
+    if (!ringsLocked) {
+        lock.lock();
+    }
+    for (auto it = m_rings.begin(); it != m_rings.end();) {
+        LogRing* ring = *it;
+        bool orphaned = ring->m_orphaned;
+        size_t head = ring->m_head.load(std::memory_order_acquire);
+        size_t tail = ring->m_tail.load(std::memory_order_relaxed);
+        if (orphaned && (head == tail)) {
+            delete ring;
+            it = m_rings.erase(it);
+            continue;
+        }
+        for (size_t i = tail; i != head; i++) {
+            LogRecord* r = &ring->m_records[i & (LOG_RING_RECORDS - 1)];
+            m_batch.emplace_back(r->timeUS, r);
+        }
+        m_batchHeads.emplace_back(ring, head);
+        ++it;
+    }
+    if (!ringsLocked) {
+        lock.unlock();
+    }
+
+    // keep the lines from all the threads in time order
+    std::stable_sort(m_batch.begin(), m_batch.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_droppedReported) {
+        char buf[128];
+        int len = snprintf(buf, sizeof(buf), "Log writer could not keep up, %llu log messages dropped\n",
+                           (unsigned long long)(dropped - m_droppedReported));
+        m_droppedReported = dropped;
+        WriteLine(buf, len);
+    }
+
+    for (auto& b : m_batch) {
+        LogRecord* r = b.second;
+        if (r->longLine) {
+            WriteLine(r->longLine->c_str(), r->longLine->size());
+            delete r->longLine;
+            r->longLine = nullptr;
         } else {
-            logFile = fopen(logFileName, "a");
-            if (!logFile) {
-                fprintf(stderr, "Error: Unable to open log file for writing!\n");
-                va_start(arg, format);
-                vfprintf(stderr, timeStr, arg);
-                va_end(arg);
-                return;
-            }
+            WriteLine(r->line, r->len);
         }
+    }
+    for (auto& h : m_batchHeads) {
+        h.first->m_tail.store(h.second, std::memory_order_release);
+    }
+
+    if (!m_batch.empty()) {
+        if (m_logFile) {
+            fflush(m_logFile);
+        }
+        fflush(stdout);
+    }
+}
+
+void _LogWrite(const char* file, int line, int level, FPPLoggerInstance& facility, const std::string& str, ...) {
+    if (!(WillLog(level, facility)))
+        return;
+    _LogWrite(file, line, level, facility, str.c_str());
+}
 
-        va_start(arg, format);
-        vfprintf(logFile, timeStr, arg);
-        va_end(arg);
+void _LogWrite(const char* file, int line, int level, FPPLoggerInstance& facility, const char* format, ...) {
+    // Don't log if we're not concerned about anything at this level
+    if (!(WillLog(level, facility)))
+        return;
 
-        if (close) {
-            fclose(logFile);
+    LogWriter* w = GetLogWriter();
+    LogRing* ring = w->m_stopped ? nullptr : w->GetThreadRing();
+
+    va_list arg;
+    va_start(arg, format);
+    if (ring) {
+        LogRecord* r = ring->beginWrite();
+        if (r) {
+            FormatLogRecord(r, file, line, facility, format, arg);
+            if (ring->commitWrite() == LOG_RING_RECORDS / 2) {
+                w->Wake();
+            }
+        } else {
+            w->m_dropped++;
+        }
+    } else {
+        // writer is shut down (exiting) or this thread is, write it directly
+        LogRecord r;
+        FormatLogRecord(&r, file, line, facility, format, arg);
+        std::unique_lock<std::timed_mutex> lock(w->m_writeLock);
+        if (r.longLine) {
+            w->WriteLine(r.longLine->c_str(), r.longLine->size());
+            delete r.longLine;
+        } else {
+            w->WriteLine(r.line, r.len);
         }
+        fflush(nullptr);
     }
-    if (strcmp(logFileName, "stdout") && logToStdOut) {
-        va_start(arg, format);
-        vfprintf(stdout, timeStr, arg);
-        va_end(arg);
+    va_end(arg);
+}
+
+bool FlushLogs(int timeoutMS) {
+    LogWriter* w = logWriter.load();
+    if (!w) {
+        return true;
     }
+    return w->Flush(timeoutMS);
 }
 
 void SetLogFile(const char* filename, bool toStdOut) {
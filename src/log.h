@@ -110,6 +110,7 @@ void _LogWrite(const char* file, int line, int level, FPPLoggerInstance& facilit
 bool WillLog(int level, FPPLoggerInstance& facility);
 
 void SetLogFile(const char* filename, bool toStdOut = true);
+bool FlushLogs(int timeoutMS = 1000); /* write out anything queued, false if the writer was busy */
 int loggingToFile(void);
 void logVersionInfo(void);
 
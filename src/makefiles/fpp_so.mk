@@ -52,6 +52,7 @@ OBJECTS_fpp_so += \
 	FileMonitor.o \
 	fppversion.o \
 	framebuffer/FrameBuffer.o \
+	framebuffer/FrameBufferConvert.o \
 	framebuffer/IOCTLFrameBuffer.o \
 	framebuffer/KMSFrameBuffer.o \
 	framebuffer/SocketFrameBuffer.o \
@@ -74,6 +75,7 @@ OBJECTS_fpp_so += \
 	Player.o \
 	OutputMonitor.o \
 	overlays/PixelOverlay.o \
+	overlays/PixelOverlayBlend.o \
     overlays/PixelOverlayEffects.o \
 	overlays/PixelOverlayModel.o \
 	overlays/PixelOverlayModelFB.o \
@@ -120,6 +122,7 @@ OBJECTS_fpp_so += \
 	sensors/Sensors.o \
 	sensors/ADS7828.o \
 	Sequence.o \
+	SequenceReencoder.o \
 	settings.o \
 	SunRise.o \
 	Timers.o \
@@ -131,6 +134,8 @@ OBJECTS_fpp_so += \
     util/ExpressionProcessor.o \
 	util/TmpFileGPIO.o \
 	util/RegExCache.o \
+	util/TimingStats.o \
+	util/DirtyRanges.o \
     $(OBJECTS_GPIO_ADDITIONS)
 
 LIBS_fpp_so += \
@@ -0,0 +1,77 @@
+
+# Tests and benchmarks, not built by default.  "make tests" and
+# "make benchmarks" build and run them.
+
+OBJECTS_FrameBufferConvertTest = \
+	framebuffer/FrameBufferConvert.o \
+	tests/FrameBufferConvertTest.o
+
+TARGETS_TESTS += tests/FrameBufferConvertTest
+OBJECTS_ALL+=$(OBJECTS_FrameBufferConvertTest)
+
+tests/FrameBufferConvertTest: $(OBJECTS_FrameBufferConvertTest)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_FrameBufferConvertTest) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
+OBJECTS_PixelOverlayBlendTest = \
+	overlays/PixelOverlayBlend.o \
+	tests/PixelOverlayBlendTest.o
+
+TARGETS_TESTS += tests/PixelOverlayBlendTest
+OBJECTS_ALL+=$(OBJECTS_PixelOverlayBlendTest)
+
+tests/PixelOverlayBlendTest: $(OBJECTS_PixelOverlayBlendTest)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_PixelOverlayBlendTest) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
+OBJECTS_FrameBufferConvertBenchmark = \
+	framebuffer/FrameBufferConvert.o \
+	tests/FrameBufferConvertBenchmark.o
+
+TARGETS_BENCHMARKS += tests/FrameBufferConvertBenchmark
+OBJECTS_ALL+=$(OBJECTS_FrameBufferConvertBenchmark)
+
+tests/FrameBufferConvertBenchmark: $(OBJECTS_FrameBufferConvertBenchmark)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_FrameBufferConvertBenchmark) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
+OBJECTS_SchedulerBenchmark = \
+	tests/SchedulerBenchmark.o
+
+TARGETS_BENCHMARKS += tests/SchedulerBenchmark
+OBJECTS_ALL+=$(OBJECTS_SchedulerBenchmark)
+
+tests/SchedulerBenchmark: $(OBJECTS_SchedulerBenchmark) libfpp.$(SHLIB_EXT)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_SchedulerBenchmark) $(LDFLAGS) $(LDFLAGS_fppd) -L . -l fpp $(LIBS_fpp_so) -o $@
+
+OBJECTS_PixelStringBenchmark = \
+	tests/PixelStringBenchmark.o
+
+TARGETS_BENCHMARKS += tests/PixelStringBenchmark
+OBJECTS_ALL+=$(OBJECTS_PixelStringBenchmark)
+
+tests/PixelStringBenchmark: $(OBJECTS_PixelStringBenchmark) libfpp.$(SHLIB_EXT)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_PixelStringBenchmark) $(LDFLAGS) $(LDFLAGS_fppd) -L . -l fpp $(LIBS_fpp_so) -o $@
+
+OBJECTS_UDPSegmentBenchmark = \
+	tests/UDPSegmentBenchmark.o
+
+TARGETS_BENCHMARKS += tests/UDPSegmentBenchmark
+OBJECTS_ALL+=$(OBJECTS_UDPSegmentBenchmark)
+
+tests/UDPSegmentBenchmark: $(OBJECTS_UDPSegmentBenchmark)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_UDPSegmentBenchmark) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
+.PHONY: tests
+tests: $(TARGETS_TESTS)
+	@for TEST in $(TARGETS_TESTS); do \
+		echo "Running $${TEST}" ; \
+		./$${TEST} || exit 1 ; \
+	done
+
+.PHONY: benchmarks
+benchmarks: $(TARGETS_BENCHMARKS)
+	@for BENCH in $(TARGETS_BENCHMARKS); do \
+		echo "Running $${BENCH}" ; \
+		./$${BENCH} || exit 1 ; \
+	done
+
+clean::
+	rm -f $(TARGETS_TESTS) $(TARGETS_BENCHMARKS)
@@ -41,27 +41,85 @@ extern "C" {
 
 // Only keep 30 frames in buffer
 #define VIDEO_FRAME_MAX 30
+// a packet can decode to more than one frame so leave a little room past VIDEO_FRAME_MAX
+#define VIDEO_FRAME_SLOTS (VIDEO_FRAME_MAX + 6)
 
 static const int DEFAULT_NUM_SAMPLES = 2048;
 
 static bool AudioHasStalled = false;
 
-class VideoFrame {
+// Fixed set of preallocated frames, filled by the decode thread and
+// consumed by ProcessVideoOverlay on the output thread.  Frames
+// [m_read, m_write) are queued, m_read is the frame currently being
+// displayed so it is never reused until the output moves past it.
+class VideoFrameRing {
 public:
-    VideoFrame(int ms, uint8_t* d, int s) :
-        data(d),
-        timestamp(ms),
-        size(s) {
-        next = nullptr;
+    VideoFrameRing() {}
+    ~VideoFrameRing() {
+        free(m_data);
     }
-    ~VideoFrame() {
-        free(data);
+
+    void init(int frameSize) {
+        free(m_data);
+        m_frameSize = frameSize;
+        m_data = (uint8_t*)malloc((size_t)frameSize * VIDEO_FRAME_SLOTS);
+        m_read = 0;
+        m_write = 0;
+    }
+    int frameSize() const { return m_frameSize; }
+    uint32_t size() const {
+        return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+    }
+
+    // producer side, the frame is only visible to the consumer once committed
+    uint8_t* beginWrite() {
+        uint32_t w = m_write.load(std::memory_order_relaxed);
+        if (!m_data || w - m_read.load(std::memory_order_acquire) >= VIDEO_FRAME_SLOTS) {
+            return nullptr;
+        }
+        return frameData(w);
+    }
+    void commitWrite(int ms) {
+        uint32_t w = m_write.load(std::memory_order_relaxed);
+        m_timestamps[w % VIDEO_FRAME_SLOTS] = ms;
+        m_write.store(w + 1, std::memory_order_release);
     }
 
-    int timestamp;
-    int size;
-    uint8_t* data;
-    VideoFrame* next;
+    // consumer side, moves to the newest frame that is due and returns it
+    uint8_t* advance(unsigned int ms) {
+        uint32_t r = m_read.load(std::memory_order_relaxed);
+        uint32_t w = m_write.load(std::memory_order_acquire);
+        if (r == w) {
+            return nullptr;
+        }
+        while ((r + 1) != w && m_timestamps[(r + 1) % VIDEO_FRAME_SLOTS] <= (int)ms) {
+            r++;
+        }
+        m_read.store(r, std::memory_order_release);
+        return frameData(r);
+    }
+    // drop queued frames before ms, only used while the consumer isn't running
+    void skipTo(int ms) {
+        uint32_t r = m_read;
+        while (r != m_write && m_timestamps[r % VIDEO_FRAME_SLOTS] < ms) {
+            r++;
+        }
+        m_read = r;
+    }
+    void clear() {
+        m_read = m_write.load();
+    }
+
+private:
+    uint8_t* frameData(uint32_t idx) const {
+        return &m_data[(size_t)(idx % VIDEO_FRAME_SLOTS) * m_frameSize];
+    }
+
+    uint8_t* m_data = nullptr;
+    int m_frameSize = 0;
+    int m_timestamps[VIDEO_FRAME_SLOTS] = {};
+    std::atomic<uint32_t> m_read = 0;
+    std::atomic<uint32_t> m_write = 0;
 };
 
 void SetChannelOutputFrameNumber(int frameNumber);
@@ -87,13 +145,9 @@ public:
         videoStream = audioStream = nullptr;
         doneRead = false;
         frame = av_frame_alloc();
-        scaledFrame = nullptr;
         au_convert_ctx = nullptr;
         decodedDataLen = 0;
         swsCtx = nullptr;
-        firstVideoFrame = lastVideoFrame = nullptr;
-        curVideoFrame = nullptr;
-        videoFrameCount = 0;
         audioDev = 0;
         outBufferPos = 0;
         currentRate = rate;
@@ -125,18 +179,6 @@ public:
             sws_freeContext(swsCtx);
             swsCtx = nullptr;
         }
-        while (firstVideoFrame) {
-            VideoFrame* t = firstVideoFrame;
-            firstVideoFrame = t->next;
-            delete t;
-        }
-        if (scaledFrame != nullptr) {
-            if (scaledFrame->data[0] != nullptr) {
-                av_free(scaledFrame->data[0]);
-            }
-
-            av_free(scaledFrame);
-        }
         if (formatContext != nullptr) {
             avformat_close_input(&formatContext);
         }
@@ -180,12 +222,11 @@ public:
     AVStream* videoStream;
     int video_dtspersec;
     int video_frames;
-    AVFrame* scaledFrame;
     SwsContext* swsCtx;
-    VideoFrame* firstVideoFrame;
-    VideoFrame* lastVideoFrame;
-    volatile VideoFrame* volatile curVideoFrame;
-    int videoFrameCount;
+    int videoWidth = 0;  // size of the overlay model, frames are scaled to it
+    int videoHeight = 0;
+    VideoFrameRing videoFrames;
+    uint32_t droppedVideoFrames = 0;
     unsigned int totalVideoLen;
     long long videoStartTime;
     PixelOverlayModel* videoOverlayModel = nullptr;
@@ -199,29 +240,36 @@ public:
     int32_t mediaOffset = 0;
     uint32_t extraDataLen = 0;
 
-    void addVideoFrame(int ms, uint8_t* d, int sz) {
-        VideoFrame* f = new VideoFrame(ms, d, sz);
-        if (firstVideoFrame == nullptr) {
-            curVideoFrame = f;
-            firstVideoFrame = f;
-            lastVideoFrame = f;
+    void addVideoFrame(int ms, AVFrame* f) {
+        uint8_t* d = videoFrames.beginWrite();
+        if (d == nullptr) {
+            if ((droppedVideoFrames++ % 100) == 0) {
+                LogDebug(VB_MEDIAOUT, "Video frame buffer full, dropped %d frames\n", droppedVideoFrames);
+            }
+            return;
+        }
+        // scale/convert straight into the ring slot at the model's size
+        swsCtx = sws_getCachedContext(swsCtx, f->width, f->height, (AVPixelFormat)f->format,
+                                      videoWidth, videoHeight, AVPixelFormat::AV_PIX_FMT_RGB24,
+                                      SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (swsCtx) {
+            uint8_t* dst[4] = { d, nullptr, nullptr, nullptr };
+            int dstLinesize[4] = { videoWidth * 3, 0, 0, 0 };
+            sws_scale(swsCtx, f->data, f->linesize, 0, f->height, dst, dstLinesize);
         } else {
-            lastVideoFrame->next = f;
-            lastVideoFrame = f;
+            memcpy(d, f->data[0], std::min(f->linesize[0] * f->height, videoFrames.frameSize()));
         }
-        ++videoFrameCount;
+        videoFrames.commitWrite(ms);
+    }
+    int videoFrameCount() const {
+        return videoFrames.size();
     }
 
     int buffersFull(bool flushaudio) {
         int retVal = -1;
         if (video_stream_idx != -1) {
             // if video
-            while (firstVideoFrame && (firstVideoFrame != curVideoFrame)) {
-                videoFrameCount--;
-                auto tmp = firstVideoFrame->next;
-                delete firstVideoFrame;
-                firstVideoFrame = tmp;
-            }
+            int videoFrameCount = this->videoFrameCount();
             retVal = (doneRead || (videoFrameCount >= VIDEO_FRAME_MAX)) ? 2
                                                                         : ((videoFrameCount >= (VIDEO_FRAME_MAX - 6)) ? 1 : 0);
             if (!flushaudio) {
@@ -274,7 +322,7 @@ public:
         return 2;
     }
     int maybeFillBuffer(bool first) {
-        if (doneRead || videoFrameCount > VIDEO_FRAME_MAX) {
+        if (doneRead || videoFrameCount() > VIDEO_FRAME_MAX) {
             // buffers are full, don't so anything
             if (AudioHasStalled)
                 LogWarn(VB_MEDIAOUT, "Stalled audio, buffers are full.  %d\n", doneRead);
@@ -327,22 +375,7 @@ public:
                 while (avcodec_send_packet(videoCodecContext, &readingPacket)) {
                     while (!avcodec_receive_frame(videoCodecContext, frame)) {
                         int ms = DTStoMS(frame->pkt_dts, video_dtspersec);
-
-                        if (swsCtx) {
-                            sws_scale(swsCtx, frame->data, frame->linesize, 0,
-                                      videoCodecContext->height, scaledFrame->data,
-                                      scaledFrame->linesize);
-
-                            int sz = scaledFrame->linesize[0] * scaledFrame->height;
-                            uint8_t* d = (uint8_t*)malloc(sz);
-                            memcpy(d, scaledFrame->data[0], sz);
-                            addVideoFrame(ms, d, sz);
-                        } else {
-                            int sz = frame->linesize[0] * frame->height;
-                            uint8_t* d = (uint8_t*)malloc(sz);
-                            memcpy(d, frame->data[0], sz);
-                            addVideoFrame(ms, d, sz);
-                        }
+                        addVideoFrame(ms, frame);
                         vidPacket = true;
                         av_frame_unref(frame);
                     }
@@ -353,7 +386,7 @@ public:
 
             if (packetOk) {
                 if (first) {
-                    if ((outBufferPos > minQueueSize || videoFrameCount > VIDEO_FRAME_MAX)) {
+                    if ((outBufferPos > minQueueSize || videoFrameCount() > VIDEO_FRAME_MAX)) {
                         return outBufferPos - orig;
                     }
                 } else if (video_stream_idx != -1 && !vidPacket) {
@@ -395,7 +428,8 @@ public:
 static int open_codec_context(int* stream_idx,
                               AVCodecContext** dec_ctx, AVFormatContext* fmt_ctx,
                               enum AVMediaType type,
-                              const std::string& src_filename) {
+                              const std::string& src_filename,
+                              int outWidth = 0, int outHeight = 0) {
     int ret, stream_index;
     AVStream* st;
     const AVCodec* dec = NULL;
@@ -427,6 +461,21 @@ static int open_codec_context(int* stream_idx,
             return ret;
         }
         (*dec_ctx)->thread_count = std::thread::hardware_concurrency() + 1;
+        if (outWidth > 0 && outHeight > 0) {
+            // if the decoder can decode at a reduced size (mjpeg and others), use
+            // the smallest one that is still at least as big as the output
+            int lowres = 0;
+            while (lowres < dec->max_lowres &&
+                   ((*dec_ctx)->width >> (lowres + 1)) >= outWidth &&
+                   ((*dec_ctx)->height >> (lowres + 1)) >= outHeight) {
+                lowres++;
+            }
+            if (lowres) {
+                LogDebug(VB_MEDIAOUT, "Decoding %dx%d video at 1/%d size for %dx%d output\n",
+                         (*dec_ctx)->width, (*dec_ctx)->height, 1 << lowres, outWidth, outHeight);
+                (*dec_ctx)->lowres = lowres;
+            }
+        }
         /* Init the decoders, with or without reference counting */
         av_dict_set(&opts, "refcounted_frames", "0", 0);
         if ((ret = avcodec_open2(*dec_ctx, dec, &opts)) < 0) {
@@ -496,23 +545,13 @@ public:
                     d->outBufferPos -= c;
                     d->maybeFillBuffer(false);
 
-                    while (d->firstVideoFrame && d->firstVideoFrame->timestamp < msTime) {
-                        VideoFrame* t = d->firstVideoFrame;
-                        d->firstVideoFrame = t->next;
-                        delete t;
-                    }
-                    d->curVideoFrame = d->firstVideoFrame;
+                    d->videoFrames.skipTo(msTime);
                     d->maybeFillBuffer(false);
                 } else {
                     // need to skip the entire chunk, just wipe it out
                     d->curPos += d->outBufferPos;
                     d->outBufferPos = 0;
-                    while (d->firstVideoFrame) {
-                        VideoFrame* t = d->firstVideoFrame;
-                        d->firstVideoFrame = t->next;
-                        delete t;
-                    }
-                    d->curVideoFrame = nullptr;
+                    d->videoFrames.clear();
                     d->maybeFillBuffer(false);
                 }
             }
@@ -633,7 +672,7 @@ void SDL::runDecode() {
                     }
                 }
             }
-            if (data->video_stream_idx != -1 && data->videoFrameCount < 15) {
+            if (data->video_stream_idx != -1 && data->videoFrameCount() < 15) {
                 // we won't sleep, need to keep decoding
                 decoding = false;
             } else {
@@ -880,20 +919,12 @@ bool SDLOutput::IsOverlayingVideo() {
 }
 bool SDLOutput::ProcessVideoOverlay(unsigned int msTimestamp) {
     SDLInternalData* data = sdlManager.data;
-    if (data && !data->stopped && data->video_stream_idx != -1 && data->curVideoFrame) {
-        while (data->curVideoFrame->next && data->curVideoFrame->next->timestamp <= msTimestamp) {
-            data->curVideoFrame = data->curVideoFrame->next;
-        }
-        if (msTimestamp <= data->totalVideoLen) {
-            VideoFrame* vf = (VideoFrame*)data->curVideoFrame;
-
-            long long t = GetTime() / 1000;
-            int t2 = ((int)t) - data->videoStartTime;
-
-            // printf("v:  %d  %d      %d        %d\n", msTimestamp, vf->timestamp, t2, sdlManager.data->videoFrameCount);
+    if (data && !data->stopped && data->video_stream_idx != -1) {
+        uint8_t* vf = data->videoFrames.advance(msTimestamp);
+        if (vf && msTimestamp <= data->totalVideoLen) {
             std::unique_lock<std::mutex> lock(data->videoOverlayModelLock);
             if (data->videoOverlayModel) {
-                data->videoOverlayModel->setData(vf->data);
+                data->videoOverlayModel->setData(vf);
                 if (data->videoOverlayModel->getState() == PixelOverlayState::Disabled) {
                     data->wasOverlayDisabled = true;
                     data->videoOverlayModel->setState(PixelOverlayState::Enabled);
@@ -1048,9 +1079,11 @@ SDLOutput::SDLOutput(const std::string& mediaFilename,
         data->videoOverlayModel = PixelOverlayManager::INSTANCE.getModel(videoOutput);
         data->videoOverlayModelName = videoOutput;
 
-        if (data->videoOverlayModel &&
-            open_codec_context(&data->video_stream_idx, &data->videoCodecContext, data->formatContext, AVMEDIA_TYPE_VIDEO, fullAudioPath.c_str()) >= 0) {
+        if (data->videoOverlayModel) {
             data->videoOverlayModel->getSize(videoOverlayWidth, videoOverlayHeight);
+        }
+        if (data->videoOverlayModel &&
+            open_codec_context(&data->video_stream_idx, &data->videoCodecContext, data->formatContext, AVMEDIA_TYPE_VIDEO, fullAudioPath.c_str(), videoOverlayWidth, videoOverlayHeight) >= 0) {
             data->videoStream = data->formatContext->streams[data->video_stream_idx];
         } else {
             data->videoStream = nullptr;
@@ -1110,20 +1143,10 @@ SDLOutput::SDLOutput(const std::string& mediaFilename,
         }
 
         data->totalVideoLen = lengthMS;
-        data->scaledFrame = av_frame_alloc();
-
-        data->scaledFrame->width = videoOverlayWidth;
-        data->scaledFrame->height = videoOverlayHeight;
-
-        data->scaledFrame->linesize[0] = data->scaledFrame->width * 3;
-        data->scaledFrame->data[0] = (uint8_t*)av_malloc(data->scaledFrame->width * data->scaledFrame->height * 3 * sizeof(uint8_t));
-
-        data->swsCtx = sws_getContext(data->videoCodecContext->width,
-                                      data->videoCodecContext->height,
-                                      data->videoCodecContext->pix_fmt,
-                                      data->scaledFrame->width, data->scaledFrame->height,
-                                      AVPixelFormat::AV_PIX_FMT_RGB24, SWS_BICUBIC, nullptr,
-                                      nullptr, nullptr);
+        // the sws context is created from the first decoded frame
+        data->videoWidth = videoOverlayWidth;
+        data->videoHeight = videoOverlayHeight;
+        data->videoFrames.init(videoOverlayWidth * videoOverlayHeight * 3);
     }
 
     data->stopped = 0;
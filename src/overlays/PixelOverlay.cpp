@@ -21,11 +21,13 @@
 
 #include <magick/type.h>
 
+#include "../channeloutput/ChannelOutputSetup.h"
 #include "../channeloutput/channeloutputthread.h"
 #include "../common.h"
 #include "../effects.h"
 #include "../log.h"
 #include "../settings.h"
+#include "../util/DirtyRanges.h"
 
 #include "PixelOverlay.h"
 #include "PixelOverlayEffects.h"
@@ -91,10 +93,91 @@ void PixelOverlayManager::PixelOverlayModelHolder::toJson(Json::Value& v) const
         model->toJson(v);
     }
 }
+// Same idea as the output prep pool, the caller claims jobs along with
+// the workers and waits for all of them to finish.
+class OverlayWorkPool {
+public:
+    OverlayWorkPool(const std::string& threadName, int numThreads) {
+        for (int x = 0; x < numThreads; x++) {
+            m_threads.emplace_back([this, threadName, x]() {
+                SetThreadName(threadName + std::to_string(x));
+                workerLoop();
+            });
+        }
+        LogDebug(VB_CHANNELOUT, "Started %d %s threads\n", numThreads, threadName.c_str());
+    }
+    ~OverlayWorkPool() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stop = true;
+        lock.unlock();
+        m_workSignal.notify_all();
+        for (auto& t : m_threads) {
+            t.join();
+        }
+    }
+
+    void run(uint32_t count, const std::function<void(uint32_t)>& job) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_job = &job;
+        m_numJobs = count;
+        m_nextJob = 0;
+        m_doneJobs = 0;
+        m_generation++;
+        lock.unlock();
+        m_workSignal.notify_all();
+
+        runJobs();
+
+        lock.lock();
+        m_doneSignal.wait(lock, [this]() { return m_doneJobs == m_numJobs && m_activeWorkers == 0; });
+        m_job = nullptr;
+    }
+
+private:
+    void workerLoop() {
+        uint32_t generation = 0;
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (!m_stop) {
+            if (m_generation != generation && m_job) {
+                generation = m_generation;
+                m_activeWorkers++;
+                lock.unlock();
+                runJobs();
+                lock.lock();
+                m_activeWorkers--;
+                m_doneSignal.notify_all();
+            } else {
+                m_workSignal.wait(lock);
+            }
+        }
+    }
+    void runJobs() {
+        for (uint32_t i = m_nextJob++; i < m_numJobs; i = m_nextJob++) {
+            (*m_job)(i);
+            m_doneJobs++;
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock;
+    std::condition_variable m_workSignal;
+    std::condition_variable m_doneSignal;
+    bool m_stop = false;
+    uint32_t m_generation = 0;
+    int m_activeWorkers = 0;
+
+    const std::function<void(uint32_t)>* m_job = nullptr;
+    uint32_t m_numJobs = 0;
+    std::atomic<uint32_t> m_nextJob = 0;
+    std::atomic<uint32_t> m_doneJobs = 0;
+};
+
 PixelOverlayManager::PixelOverlayManager() :
-    numActive(0) {
+    numActive(0),
+    parallelOverlays(false) {
 }
 PixelOverlayManager::~PixelOverlayManager() {
+    groupPool.reset();
     if (updateThread != nullptr) {
         std::unique_lock<std::mutex> l(threadLock);
         threadKeepRunning = false;
@@ -104,6 +187,7 @@ PixelOverlayManager::~PixelOverlayManager() {
         delete updateThread;
         updateThread = nullptr;
     }
+    effectPool.reset();
     for (auto a : models) {
         if (a.second.model) {
             delete a.second.model;
@@ -115,6 +199,11 @@ PixelOverlayManager::~PixelOverlayManager() {
 void PixelOverlayManager::Initialize() {
     loadModelMap();
     loadFonts();
+
+    parallelOverlays = getSettingInt("ParallelOverlays");
+    registerSettingsListener("PixelOverlayManager", "ParallelOverlays", [this](const std::string& value) {
+        parallelOverlays = getSettingInt("ParallelOverlays");
+    });
 }
 
 void PixelOverlayManager::addModel(Json::Value config) {
@@ -302,11 +391,13 @@ void PixelOverlayManager::modelStateChanged(PixelOverlayModel* m, const PixelOve
         // enabling, add
         std::unique_lock<std::recursive_mutex> lock(activeModelsLock);
         activeModels.push_back(m);
+        overlayGroupsDirty = true;
         numActive++;
     } else if (state.getState() == 0) {
         // disabling, remove
         std::unique_lock<std::recursive_mutex> lock(activeModelsLock);
         activeModels.remove(m);
+        overlayGroupsDirty = true;
         numActive--;
     }
     if (numActive > 0) {
@@ -318,6 +409,7 @@ void PixelOverlayManager::doOverlays(uint8_t* channels) {
     if (numActive == 0) {
         return;
     }
+    uint64_t startTime = GetTimeMicros();
     std::unique_lock<std::recursive_mutex> lock(activeModelsLock);
     // First, flush any buffers
     for (auto m : activeModels) {
@@ -325,16 +417,30 @@ void PixelOverlayManager::doOverlays(uint8_t* channels) {
             m->flushOverlayBuffer();
         }
     }
-    // Second, do any sub-models
-    for (auto m : activeModels) {
-        if (m->getType() == "Sub") {
-            m->doOverlay(channels);
-        }
+    if (overlayGroupsDirty) {
+        buildOverlayGroups();
+    }
+    // Second, do any sub-models, they write through their parent which
+    // may be in any group so they are always done first and serially
+    for (auto m : activeSubModels) {
+        m->doOverlay(channels);
     }
     // Then do any non-subs
-    for (auto m : activeModels) {
-        if (m->getType() != "Sub") {
-            m->doOverlay(channels);
+    if (parallelOverlays && overlayGroups.size() > 1) {
+        if (!groupPool) {
+            groupPool = std::make_unique<OverlayWorkPool>("FPP-Overlay", std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 3));
+        }
+        std::function<void(uint32_t)> job = [this, channels](uint32_t idx) {
+            for (auto m : overlayGroups[idx]) {
+                m->doOverlay(channels);
+            }
+        };
+        groupPool->run(overlayGroups.size(), job);
+    } else {
+        for (auto& g : overlayGroups) {
+            for (auto m : g) {
+                m->doOverlay(channels);
+            }
         }
     }
 
@@ -342,8 +448,10 @@ void PixelOverlayManager::doOverlays(uint8_t* channels) {
         for (int s = m.start; s <= m.end; s++) {
             channels[s] = m.value;
         }
+        channelDataChanges.markDirty(m.start, m.end - m.start + 1);
     }
     lock.unlock();
+    compositeTimes.addSample(GetTimeMicros() - startTime);
     std::unique_lock<std::mutex> l(threadLock);
     while (!afterOverlayModels.empty()) {
         PixelOverlayModel* m = afterOverlayModels.front();
@@ -354,6 +462,57 @@ void PixelOverlayManager::doOverlays(uint8_t* channels) {
     }
 }
 
+// must be called with activeModelsLock held
+void PixelOverlayManager::buildOverlayGroups() {
+    activeSubModels.clear();
+    overlayGroups.clear();
+
+    // (start, end, model index) sorted by start, overlapping ranges are merged
+    // into the same group
+    std::vector<PixelOverlayModel*> models;
+    std::vector<std::tuple<int, int, int>> ranges;
+    for (auto m : activeModels) {
+        if (m->getType() == "Sub") {
+            activeSubModels.push_back(m);
+        } else {
+            ranges.emplace_back(m->getStartChannel(), m->getStartChannel() + std::max(m->getChannelCount(), 1), models.size());
+            models.push_back(m);
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<int> groupOf(models.size());
+    int end = -1;
+    int groups = 0;
+    for (auto& r : ranges) {
+        if (groups == 0 || std::get<0>(r) >= end) {
+            ++groups;
+            end = std::get<1>(r);
+        } else {
+            end = std::max(end, std::get<1>(r));
+        }
+        groupOf[std::get<2>(r)] = groups - 1;
+    }
+    // fill the groups in activeModels order to keep the z-order
+    overlayGroups.resize(groups);
+    for (int x = 0; x < models.size(); x++) {
+        overlayGroups[groupOf[x]].push_back(models[x]);
+    }
+    overlayGroupsDirty = false;
+}
+
+void PixelOverlayManager::GetStats(Json::Value& result) {
+    std::unique_lock<std::recursive_mutex> lock(activeModelsLock);
+    result["activeModels"] = (int)activeModels.size();
+    result["groups"] = (int)overlayGroups.size();
+    result["parallel"] = parallelOverlays.load();
+    lock.unlock();
+    compositeTimes.toJson(result["composite"]);
+}
+
+void PixelOverlayManager::ResetStats() {
+    compositeTimes.reset();
+}
+
 PixelOverlayModel* PixelOverlayManager::getModel(const std::string& name) {
     std::unique_lock<std::recursive_mutex> lock(modelsLock);
     return getModelLocked(name);
@@ -833,7 +992,7 @@ public:
     EnableOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model State", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({ "Disabled", "Enabled", "Transparent", "TransparentRGB" }));
+        args.push_back(CommandArg("State", "string", "State").setContentList({ "Disabled", "Enabled", "Transparent", "TransparentRGB", "Additive", "Maximum", "AlphaBlend" }));
     }
 
     virtual std::unique_ptr<Command::Result> run(const std::vector<std::string>& args) override {
@@ -888,7 +1047,7 @@ public:
     FillOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model Fill", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({ "Don't Set", "Enabled", "Transparent", "TransparentRGB" }));
+        args.push_back(CommandArg("State", "string", "State").setContentList({ "Don't Set", "Enabled", "Transparent", "TransparentRGB", "Additive", "Maximum", "AlphaBlend" }));
         args.push_back(CommandArg("Color", "color", "Color").setDefaultValue("#FF0000"));
     }
 
@@ -977,7 +1136,7 @@ public:
     ApplyEffectOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model Effect", m) {
         args.push_back(CommandArg("Models", "multistring", "Models").setContentListUrl("api/models?simple=true&all=true", false));
-        args.push_back(CommandArg("AutoEnable", "string", "Auto Enable/Disable").setContentList({ "False", "Enabled", "Transparent", "Transparent RGB" }).setDefaultValue("Enabled"));
+        args.push_back(CommandArg("AutoEnable", "string", "Auto Enable/Disable").setContentList({ "False", "Enabled", "Transparent", "Transparent RGB", "Additive", "Maximum", "Alpha Blend" }).setDefaultValue("Enabled"));
         args.push_back(CommandArg("Effect", "subcommand", "Effect").setContentListUrl("api/overlays/effects/", false));
     }
 
@@ -1057,6 +1216,7 @@ void PixelOverlayManager::removeAutoOverlayModel(const std::string& name) {
         removePeriodicUpdate(pmodel);
         std::unique_lock<std::recursive_mutex> alock(activeModelsLock);
         activeModels.remove(pmodel);
+        overlayGroupsDirty = true;
         alock.unlock();
 
         delete pmodel;
@@ -1095,25 +1255,39 @@ void PixelOverlayManager::doOverlayModelEffects() {
         if (!updates.empty()) {
             uint64_t curTime = GetTimeMS();
             while (!updates.empty() && updates.begin()->first <= curTime) {
-                std::list<PixelOverlayModel*> models = updates.begin()->second;
-                uint64_t startTime = updates.begin()->first;
-                updates.erase(updates.begin());
+                // grab everything that is due so they can all be updated at once
+                std::vector<std::pair<uint64_t, PixelOverlayModel*>> models;
+                while (!updates.empty() && updates.begin()->first <= curTime) {
+                    for (auto m : updates.begin()->second) {
+                        models.emplace_back(updates.begin()->first, m);
+                    }
+                    updates.erase(updates.begin());
+                }
                 l.unlock();
 
-                for (auto m : models) {
-                    int32_t ms = m->updateRunningEffects();
-                    if (ms != 0) {
-                        l.lock();
-                        if (ms > 0) {
-                            uint64_t t = startTime + ms;
-                            updates[t].push_back(m);
-                        } else {
-                            afterOverlayModels.push_back(m);
-                        }
-                        l.unlock();
+                std::vector<int32_t> results(models.size());
+                if (parallelOverlays && models.size() > 1) {
+                    if (!effectPool) {
+                        effectPool = std::make_unique<OverlayWorkPool>("FPP-OverlayFX", std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 3));
+                    }
+                    std::function<void(uint32_t)> job = [&models, &results](uint32_t idx) {
+                        results[idx] = models[idx].second->updateRunningEffects();
+                    };
+                    effectPool->run(models.size(), job);
+                } else {
+                    for (int x = 0; x < models.size(); x++) {
+                        results[x] = models[x].second->updateRunningEffects();
                     }
                 }
+
                 l.lock();
+                for (int x = 0; x < models.size(); x++) {
+                    if (results[x] > 0) {
+                        updates[models[x].first + results[x]].push_back(models[x].second);
+                    } else if (results[x] < 0) {
+                        afterOverlayModels.push_back(models[x].second);
+                    }
+                }
                 curTime = GetTimeMS();
             }
             if (!updates.empty()) {
@@ -1126,7 +1300,7 @@ void PixelOverlayManager::doOverlayModelEffects() {
 void PixelOverlayManager::removePeriodicUpdate(PixelOverlayModel* m) {
     std::unique_lock<std::mutex> l(threadLock);
     for (auto& a : updates) {
-        updates.begin()->second.remove(m);
+        a.second.remove(m);
     }
     afterOverlayModels.remove(m);
 }
@@ -16,13 +16,18 @@
 #include <httpserver.hpp>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "../util/TimingStats.h"
 
 class PixelOverlayState;
 class PixelOverlayModel;
 class OverlayRange;
+class OverlayWorkPool;
 
 class PixelOverlayManager : public httpserver::http_resource {
 public:
@@ -35,6 +40,8 @@ public:
 
     bool hasActiveOverlays();
     void doOverlays(uint8_t* channels);
+    void GetStats(Json::Value& result);
+    void ResetStats();
     void modelStateChanged(PixelOverlayModel*, const PixelOverlayState& old, const PixelOverlayState& state);
 
     void addModel(Json::Value config);
@@ -89,6 +96,18 @@ private:
     std::list<OverlayRange> activeRanges;
     std::recursive_mutex activeModelsLock;
 
+    // The active non-Sub models split into groups that don't share any
+    // channels.  Models within a group are composited in z-order, separate
+    // groups can be composited in parallel.  Rebuilt when the active
+    // models change.
+    void buildOverlayGroups();
+    std::vector<PixelOverlayModel*> activeSubModels;
+    std::vector<std::vector<PixelOverlayModel*>> overlayGroups;
+    bool overlayGroupsDirty = true;
+    std::atomic_bool parallelOverlays;
+    std::unique_ptr<OverlayWorkPool> groupPool;
+    TimingStats compositeTimes;
+
     std::map<std::string, PixelOverlayModelHolder> models;
     std::list<std::string> modelNames;
     std::map<std::string, std::string> fonts;
@@ -100,6 +119,7 @@ private:
     bool threadKeepRunning = true;
     std::mutex threadLock;
     std::condition_variable threadCV;
+    std::unique_ptr<OverlayWorkPool> effectPool; // only used by updateThread
     std::map<uint64_t, std::list<PixelOverlayModel*>> updates;
     std::list<PixelOverlayModel*> afterOverlayModels;
 
@@ -0,0 +1,217 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "PixelOverlayBlend.h"
+
+// d * (255 - a) / 255, rounded
+static inline uint8_t ScaleInverse(uint8_t d, uint8_t a) {
+    uint32_t x = d * (255 - a) + 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint8_t BlendChannel(PixelOverlayState::PixelState st, uint8_t d, uint8_t s) {
+    switch (st) {
+    case PixelOverlayState::Transparent:
+        return s ? s : d;
+    case PixelOverlayState::Additive:
+        return std::min(d + s, 255);
+    case PixelOverlayState::Maximum:
+        return std::max(d, s);
+    case PixelOverlayState::AlphaBlend:
+        // single channel, it's its own alpha
+        return s + ScaleInverse(d, s);
+    default:
+        return s;
+    }
+}
+
+void BlendOverlayPixel(PixelOverlayState::PixelState st, uint8_t* const dst[3], const uint8_t* src) {
+    switch (st) {
+    case PixelOverlayState::TransparentRGB:
+        if (src[0] | src[1] | src[2]) {
+            for (int c = 0; c < 3; c++) {
+                if (dst[c]) {
+                    *dst[c] = src[c];
+                }
+            }
+        }
+        break;
+    case PixelOverlayState::AlphaBlend: {
+        uint8_t a = std::max(std::max(src[0], src[1]), src[2]);
+        for (int c = 0; c < 3; c++) {
+            if (dst[c]) {
+                *dst[c] = src[c] + ScaleInverse(*dst[c], a);
+            }
+        }
+    } break;
+    default:
+        for (int c = 0; c < 3; c++) {
+            if (dst[c]) {
+                *dst[c] = BlendChannel(st, *dst[c], src[c]);
+            }
+        }
+        break;
+    }
+}
+
+static void BlendTransparent(uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= count; x += 16) {
+        uint8x16_t s = vld1q_u8(src + x);
+        uint8x16_t d = vld1q_u8(dst + x);
+        vst1q_u8(dst + x, vbslq_u8(vtstq_u8(s, s), s, d));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= count; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        // where s is 0 keep d, elsewhere d is masked off and s is used
+        d = _mm_and_si128(d, _mm_cmpeq_epi8(s, zero));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(d, s));
+    }
+#endif
+    for (; x < count; x++) {
+        if (src[x]) {
+            dst[x] = src[x];
+        }
+    }
+}
+
+static void BlendAdditive(uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= count; x += 16) {
+        vst1q_u8(dst + x, vqaddq_u8(vld1q_u8(dst + x), vld1q_u8(src + x)));
+    }
+#elif defined(__SSE2__)
+    for (; x + 16 <= count; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_adds_epu8(d, s));
+    }
+#endif
+    for (; x < count; x++) {
+        dst[x] = std::min(dst[x] + src[x], 255);
+    }
+}
+
+static void BlendMaximum(uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= count; x += 16) {
+        vst1q_u8(dst + x, vmaxq_u8(vld1q_u8(dst + x), vld1q_u8(src + x)));
+    }
+#elif defined(__SSE2__)
+    for (; x + 16 <= count; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_max_epu8(d, s));
+    }
+#endif
+    for (; x < count; x++) {
+        dst[x] = std::max(dst[x], src[x]);
+    }
+}
+
+static void BlendTransparentRGB(uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 48 <= count; x += 48) {
+        uint8x16x3_t s = vld3q_u8(src + x);
+        uint8x16x3_t d = vld3q_u8(dst + x);
+        uint8x16_t any = vorrq_u8(vorrq_u8(s.val[0], s.val[1]), s.val[2]);
+        uint8x16_t m = vtstq_u8(any, any);
+        for (int c = 0; c < 3; c++) {
+            d.val[c] = vbslq_u8(m, s.val[c], d.val[c]);
+        }
+        vst3q_u8(dst + x, d);
+    }
+#endif
+    for (; x + 3 <= count; x += 3) {
+        // branchless so the compiler can at least unroll it
+        uint8_t m = -(uint8_t)((src[x] | src[x + 1] | src[x + 2]) != 0);
+        for (int c = 0; c < 3; c++) {
+            dst[x + c] = (src[x + c] & m) | (dst[x + c] & ~m);
+        }
+    }
+    for (; x < count; x++) {
+        if (src[x]) {
+            dst[x] = src[x];
+        }
+    }
+}
+
+static void BlendAlpha(uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 48 <= count; x += 48) {
+        uint8x16x3_t s = vld3q_u8(src + x);
+        uint8x16x3_t d = vld3q_u8(dst + x);
+        uint8x16_t inv = vmvnq_u8(vmaxq_u8(vmaxq_u8(s.val[0], s.val[1]), s.val[2]));
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t lo = vmull_u8(vget_low_u8(d.val[c]), vget_low_u8(inv));
+            uint16x8_t hi = vmull_u8(vget_high_u8(d.val[c]), vget_high_u8(inv));
+            // rounded divide by 255, same as ScaleInverse
+            uint8x16_t scaled = vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+            d.val[c] = vqaddq_u8(s.val[c], scaled);
+        }
+        vst3q_u8(dst + x, d);
+    }
+#endif
+    for (; x + 3 <= count; x += 3) {
+        uint8_t a = std::max(std::max(src[x], src[x + 1]), src[x + 2]);
+        for (int c = 0; c < 3; c++) {
+            dst[x + c] = src[x + c] + ScaleInverse(dst[x + c], a);
+        }
+    }
+    for (; x < count; x++) {
+        dst[x] = BlendChannel(PixelOverlayState::AlphaBlend, dst[x], src[x]);
+    }
+}
+
+void BlendOverlayData(PixelOverlayState::PixelState st, uint8_t* dst, const uint8_t* src, int count) {
+    switch (st) {
+    case PixelOverlayState::Enabled:
+        memcpy(dst, src, count);
+        break;
+    case PixelOverlayState::Transparent:
+        BlendTransparent(dst, src, count);
+        break;
+    case PixelOverlayState::TransparentRGB:
+        BlendTransparentRGB(dst, src, count);
+        break;
+    case PixelOverlayState::Additive:
+        BlendAdditive(dst, src, count);
+        break;
+    case PixelOverlayState::Maximum:
+        BlendMaximum(dst, src, count);
+        break;
+    case PixelOverlayState::AlphaBlend:
+        BlendAlpha(dst, src, count);
+        break;
+    default:
+        break;
+    }
+}
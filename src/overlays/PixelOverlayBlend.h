@@ -0,0 +1,24 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <cstdint>
+
+#include "PixelOverlayModel.h"
+
+// Blend count bytes of src onto dst using the given overlay state.  The
+// per pixel states (TransparentRGB, AlphaBlend) expect RGB triplets, any
+// partial pixel at the end is blended per channel.
+void BlendOverlayData(PixelOverlayState::PixelState st, uint8_t* dst, const uint8_t* src, int count);
+
+// Blend a single RGB pixel, dst[i] is null for channels that aren't mapped
+void BlendOverlayPixel(PixelOverlayState::PixelState st, uint8_t* const dst[3], const uint8_t* src);
@@ -49,8 +49,11 @@
 #include "../effects.h"
 #include "../log.h"
 #include "../settings.h"
+#include "../channeloutput/ChannelOutputSetup.h"
+#include "../util/DirtyRanges.h"
 
 #include "PixelOverlay.h"
+#include "PixelOverlayBlend.h"
 #include "PixelOverlayEffects.h"
 #include "PixelOverlayModel.h"
 
@@ -346,6 +349,7 @@ void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlaySt
                 it->yoffset = oy;
                 it->width = w;
                 it->height = h;
+                buildChildRuns(*it);
             }
         }
         it++;
@@ -359,6 +363,7 @@ void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlaySt
         cms.yoffset = oy;
         cms.width = w;
         cms.height = h;
+        buildChildRuns(cms);
         children.push_back(cms);
     }
     bool hasChildren = !children.empty();
@@ -369,60 +374,46 @@ void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlaySt
     }
 }
 
+void PixelOverlayModel::buildChildRuns(ChildModelState& c) {
+    c.runs.clear();
+    c.pixels.clear();
+    int x0 = std::max(c.xoffset, 0);
+    int x1 = std::min(c.xoffset + c.width, width);
+    int y0 = std::max(c.yoffset, 0);
+    int y1 = std::min(c.yoffset + c.height, height);
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            int off = (y * width + x) * 3;
+            uint32_t ch = channelMap[off];
+            if (ch == FPPD_OFF_CHANNEL || channelMap[off + 1] != ch + 1 || channelMap[off + 2] != ch + 2) {
+                c.pixels.push_back(off);
+            } else if (!c.runs.empty() && c.runs.back().first + c.runs.back().second == ch) {
+                c.runs.back().second += 3;
+            } else {
+                c.runs.emplace_back(ch, 3);
+            }
+        }
+    }
+}
+
 bool PixelOverlayModel::flushChildren(uint8_t* dst) {
     if (children.empty()) {
         return false;
     }
     for (auto& c : children) {
-        int cst = c.state.getState();
-        for (int y = 0; y < c.height; y++) {
-            int yoff = (y + c.yoffset) * width * 3;
-            for (int x = 0; x < c.width; x++) {
-                int offr = (x + c.xoffset) * 3 + yoff;
-                int offg = offr + 1;
-                int offb = offr + 2;
-
-                switch (cst) {
-                case 1:
-                    if (channelMap[offr] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offr]] = channelData[channelMap[offr]];
-                    }
-                    if (channelMap[offg] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offg]] = channelData[channelMap[offg]];
-                    }
-                    if (channelMap[offb] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offb]] = channelData[channelMap[offb]];
-                    }
-                    break;
-                case 2:
-                    if (channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]]) {
-                        dst[channelMap[offr]] = channelData[channelMap[offr]];
-                    }
-                    if (channelMap[offg] != FPPD_OFF_CHANNEL && channelData[channelMap[offg]]) {
-                        dst[channelMap[offg]] = channelData[channelMap[offg]];
-                    }
-                    if (channelMap[offb] != FPPD_OFF_CHANNEL && channelData[channelMap[offb]]) {
-                        dst[channelMap[offb]] = channelData[channelMap[offb]];
-                    }
-                    break;
-                case 3:
-                    bool cp = channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]];
-                    cp |= channelMap[offg] != FPPD_OFF_CHANNEL && channelData[channelMap[offg]];
-                    cp |= channelMap[offb] != FPPD_OFF_CHANNEL && channelData[channelMap[offb]];
-                    if (cp) {
-                        if (channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]]) {
-                            dst[channelMap[offr]] = channelData[offr];
-                        }
-                        if (channelMap[offg] != FPPD_OFF_CHANNEL && channelData[offg]) {
-                            dst[channelMap[offg]] = channelData[offg];
-                        }
-                        if (channelMap[offb] != FPPD_OFF_CHANNEL && channelData[offb]) {
-                            dst[channelMap[offb]] = channelData[offb];
-                        }
-                    }
-                    break;
-                }
+        PixelOverlayState::PixelState cst = c.state.getState();
+        for (auto& r : c.runs) {
+            BlendOverlayData(cst, &dst[r.first], &channelData[r.first], r.second);
+        }
+        for (auto off : c.pixels) {
+            uint8_t* d[3];
+            uint8_t s[3];
+            for (int i = 0; i < 3; i++) {
+                uint32_t ch = channelMap[off + i];
+                d[i] = ch == FPPD_OFF_CHANNEL ? nullptr : &dst[ch];
+                s[i] = ch == FPPD_OFF_CHANNEL ? 0 : channelData[ch];
             }
+            BlendOverlayPixel(cst, d, s);
         }
     }
     return true;
@@ -431,6 +422,8 @@ bool PixelOverlayModel::flushChildren(uint8_t* dst) {
 void PixelOverlayModel::doOverlay(uint8_t* channels) {
     int st = state.getState();
     uint8_t* dst = &channels[startChannel];
+    channelDataChanges.markDirty(startChannel, channelCount);
+    std::unique_lock<std::mutex> dl(dataLock);
     if (st == 0 && !children.empty()) {
         // this model is disable, but we have children that are
         // enabled.  Thus, we need to apply their blending
@@ -439,7 +432,7 @@ void PixelOverlayModel::doOverlay(uint8_t* channels) {
         dirtyBuffer = false;
         return;
     }
-    if (((st == 2) || (st == 3)) &&
+    if ((st >= PixelOverlayState::Transparent) &&
         (!IsEffectRunning()) &&
         (!sequence->IsSequenceRunning()) &&
         !PluginManager::INSTANCE.hasPlugins()) {
@@ -447,38 +440,24 @@ void PixelOverlayModel::doOverlay(uint8_t* channels) {
         st = 1;
     }
 
-    uint8_t* src = channelData;
-    switch (st) {
-    case 1: // Active - Opaque
-        memcpy(dst, src, channelCount);
-        break;
-    case 2: // Active Transparent
-        for (int j = 0; j < channelCount; j++, src++, dst++) {
-            if (*src) {
-                *dst = *src;
-            }
-        }
-        break;
-    case 3: // Active Transparent RGB {
-        for (int j = 0; j < channelCount; j += 3, src += 3, dst += 3) {
-            if (src[0] || src[1] || src[2]) {
-                dst[0] = src[0];
-                dst[1] = src[1];
-                dst[2] = src[2];
-            }
-        }
-        break;
-    }
+    BlendOverlayData((PixelOverlayState::PixelState)st, dst, channelData, channelCount);
 
     dirtyBuffer = false;
 }
 
 void PixelOverlayModel::setData(const uint8_t* data) {
+    std::unique_lock<std::mutex> bl(backBufferLock);
+    if (backBuffer.size() != channelCount) {
+        backBuffer.resize(channelCount);
+    }
+    uint8_t* bb = backBuffer.data();
     for (int c = 0; c < (width * height * 3); c++) {
         if (channelMap[c] != FPPD_OFF_CHANNEL) {
-            channelData[channelMap[c]] = data[c];
+            bb[channelMap[c]] = data[c];
         }
     }
+    std::unique_lock<std::mutex> dl(dataLock);
+    memcpy(channelData, bb, channelCount);
     dirtyBuffer = true;
 }
 
@@ -519,18 +498,14 @@ void PixelOverlayModel::setData(const uint8_t* data, int xOffset, int yOffset, i
                         channelData[channelMap[c]] = data[s];
                     }
                 }
-            } else if (cst == 3) {
-                bool b = data[s] | data[s + 1] | data[s + 2];
-                if (b) {
-                    for (int i = 0; i < 3; i++, c++, s++) {
-                        if (channelMap[c] != FPPD_OFF_CHANNEL) {
-                            channelData[channelMap[c]] = data[s];
-                        }
-                    }
-                } else {
-                    s += 3;
-                    c += 3;
+            } else {
+                uint8_t* d[3];
+                for (int i = 0; i < 3; i++) {
+                    d[i] = channelMap[c + i] == FPPD_OFF_CHANNEL ? nullptr : &channelData[channelMap[c + i]];
                 }
+                BlendOverlayPixel(st.getState(), d, &data[s]);
+                s += 3;
+                c += 3;
             }
         }
         c += rowWrap;
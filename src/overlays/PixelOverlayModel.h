@@ -14,6 +14,7 @@
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 class RunningEffect;
 
@@ -23,7 +24,10 @@ public:
         Disabled,
         Enabled,
         Transparent,
-        TransparentRGB
+        TransparentRGB,
+        Additive,   // saturating add
+        Maximum,    // brightest of each channel
+        AlphaBlend  // brightest channel of each pixel is its alpha
     };
 
     PixelOverlayState() :
@@ -41,6 +45,12 @@ public:
             state = PixelState::Transparent;
         } else if (v == "TransparentRGB" || v == "Transparent RGB") {
             state = PixelState::TransparentRGB;
+        } else if (v == "Additive") {
+            state = PixelState::Additive;
+        } else if (v == "Maximum" || v == "Max") {
+            state = PixelState::Maximum;
+        } else if (v == "AlphaBlend" || v == "Alpha Blend" || v == "Alpha") {
+            state = PixelState::AlphaBlend;
         } else {
             state = PixelState::Disabled;
         }
@@ -138,6 +148,14 @@ protected:
     std::vector<uint32_t> channelMap;
     uint8_t* channelData;
 
+    // Full frames (setData(data), flushOverlayBuffer) are mapped into
+    // backBuffer and then copied into channelData under dataLock, which
+    // doOverlay also holds, so a frame rendered on another thread is never
+    // blended half written.
+    std::mutex dataLock;
+    std::mutex backBufferLock;
+    std::vector<uint8_t> backBuffer;
+
     volatile bool dirtyBuffer = false;
 
     struct OverlayBufferData {
@@ -159,6 +177,12 @@ protected:
         int yoffset = 0;
         int width = 0;
         int height = 0;
+
+        // (offset, count) runs of contiguous channelData covered by the
+        // child and the offsets of any pixels that aren't contiguous
+        std::vector<std::pair<uint32_t, uint32_t>> runs;
+        std::vector<uint32_t> pixels;
     };
     std::list<ChildModelState> children;
+    void buildChildRuns(ChildModelState& c);
 };
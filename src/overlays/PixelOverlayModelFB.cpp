@@ -44,12 +44,15 @@ void PixelOverlayModelFB::doOverlay(uint8_t* channels) {
     if (children.empty() && !dirtyBuffer)
         return;
 
+    std::unique_lock<std::mutex> dl(dataLock);
     fb->FBCopyData(channelData);
+    dl.unlock();
     fb->FBStartDraw();
     dirtyBuffer = false;
 }
 
 void PixelOverlayModelFB::setData(const uint8_t* data) {
+    std::unique_lock<std::mutex> dl(dataLock);
     memcpy(channelData, data, width * height * 3);
     dirtyBuffer = true;
 }
@@ -16,6 +16,7 @@
 #ifndef WS2812FX_h
 #define WS2812FX_h
 
+#include <atomic>
 #include <vector>
 #include "wled.h"
 
@@ -476,23 +477,24 @@ typedef struct Segment {
     };
     uint8_t         _default_palette;  // palette number that gets assigned to pal0
     unsigned        _dataLen;
-    static unsigned _usedSegmentData;
-    static uint8_t  _segBri;                  // brightness of segment for current effect
-    static unsigned _vLength;                 // 1D dimension used for current effect
-    static unsigned _vWidth, _vHeight;        // 2D dimensions used for current effect
-    static uint32_t _currentColors[NUM_COLORS]; // colors used for current effect
-    static bool     _colorScaled;             // color has been scaled prior to setPixelColor() call
-    static CRGBPalette16 _currentPalette;     // palette used for current effect (includes transition, used in color_from_palette())
-    static CRGBPalette16 _randomPalette;      // actual random palette
-    static CRGBPalette16 _newRandomPalette;   // target random palette
-    static uint16_t _lastPaletteChange;       // last random palette change time in millis()/1000
-    static uint16_t _lastPaletteBlend;        // blend palette according to set Transition Delay in millis()%0xFFFF
-    static uint16_t _transitionprogress;      // current transition progress 0 - 0xFFFF
+    // FPP: the "current effect" state is per thread so strips can be rendered on separate threads
+    static std::atomic<unsigned> _usedSegmentData;
+    static thread_local uint8_t  _segBri;                  // brightness of segment for current effect
+    static thread_local unsigned _vLength;                 // 1D dimension used for current effect
+    static thread_local unsigned _vWidth, _vHeight;        // 2D dimensions used for current effect
+    static thread_local uint32_t _currentColors[NUM_COLORS]; // colors used for current effect
+    static thread_local bool     _colorScaled;             // color has been scaled prior to setPixelColor() call
+    static thread_local CRGBPalette16 _currentPalette;     // palette used for current effect (includes transition, used in color_from_palette())
+    static thread_local CRGBPalette16 _randomPalette;      // actual random palette
+    static thread_local CRGBPalette16 _newRandomPalette;   // target random palette
+    static thread_local uint16_t _lastPaletteChange;       // last random palette change time in millis()/1000
+    static thread_local uint16_t _lastPaletteBlend;        // blend palette according to set Transition Delay in millis()%0xFFFF
+    static thread_local uint16_t _transitionprogress;      // current transition progress 0 - 0xFFFF
     #ifndef WLED_DISABLE_MODE_BLEND
-    static bool          _modeBlend;          // mode/effect blending semaphore
+    static thread_local bool          _modeBlend;          // mode/effect blending semaphore
     // clipping
-    static uint16_t _clipStart, _clipStop;
-    static uint8_t  _clipStartY, _clipStopY;
+    static thread_local uint16_t _clipStart, _clipStop;
+    static thread_local uint8_t  _clipStartY, _clipStopY;
     #endif
 
     // transition data, valid only if transitional==true, holds values during transition (72 bytes)
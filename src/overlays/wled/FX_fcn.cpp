@@ -74,28 +74,28 @@ static constexpr bool validatePinsAndTypes(const unsigned* types, unsigned numTy
 ///////////////////////////////////////////////////////////////////////////////
 // Segment class implementation
 ///////////////////////////////////////////////////////////////////////////////
-unsigned      Segment::_usedSegmentData   = 0U; // amount of RAM all segments use for their data[]
+std::atomic<unsigned> Segment::_usedSegmentData = 0U; // amount of RAM all segments use for their data[]
 uint16_t      Segment::maxWidth           = DEFAULT_LED_COUNT;
 uint16_t      Segment::maxHeight          = 1;
-unsigned      Segment::_vLength           = 0;
-unsigned      Segment::_vWidth            = 0;
-unsigned      Segment::_vHeight           = 0;
-uint8_t       Segment::_segBri            = 0;
-uint32_t      Segment::_currentColors[NUM_COLORS] = {0,0,0};
-bool          Segment::_colorScaled       = false;
-CRGBPalette16 Segment::_currentPalette    = CRGBPalette16(CRGB::Black);
-CRGBPalette16 Segment::_randomPalette     = generateRandomPalette();  // was CRGBPalette16(DEFAULT_COLOR);
-CRGBPalette16 Segment::_newRandomPalette  = generateRandomPalette();  // was CRGBPalette16(DEFAULT_COLOR);
-uint16_t      Segment::_lastPaletteChange = 0; // perhaps it should be per segment
-uint16_t      Segment::_lastPaletteBlend  = 0; //in millis (lowest 16 bits only)
-uint16_t      Segment::_transitionprogress  = 0xFFFF;
+thread_local unsigned      Segment::_vLength           = 0;
+thread_local unsigned      Segment::_vWidth            = 0;
+thread_local unsigned      Segment::_vHeight           = 0;
+thread_local uint8_t       Segment::_segBri            = 0;
+thread_local uint32_t      Segment::_currentColors[NUM_COLORS] = {0,0,0};
+thread_local bool          Segment::_colorScaled       = false;
+thread_local CRGBPalette16 Segment::_currentPalette    = CRGBPalette16(CRGB::Black);
+thread_local CRGBPalette16 Segment::_randomPalette     = generateRandomPalette();  // was CRGBPalette16(DEFAULT_COLOR);
+thread_local CRGBPalette16 Segment::_newRandomPalette  = generateRandomPalette();  // was CRGBPalette16(DEFAULT_COLOR);
+thread_local uint16_t      Segment::_lastPaletteChange = 0; // perhaps it should be per segment
+thread_local uint16_t      Segment::_lastPaletteBlend  = 0; //in millis (lowest 16 bits only)
+thread_local uint16_t      Segment::_transitionprogress  = 0xFFFF;
 
 #ifndef WLED_DISABLE_MODE_BLEND
-bool Segment::_modeBlend = false;
-uint16_t Segment::_clipStart = 0;
-uint16_t Segment::_clipStop = 0;
-uint8_t  Segment::_clipStartY = 0;
-uint8_t  Segment::_clipStopY = 1;
+thread_local bool Segment::_modeBlend = false;
+thread_local uint16_t Segment::_clipStart = 0;
+thread_local uint16_t Segment::_clipStop = 0;
+thread_local uint8_t  Segment::_clipStartY = 0;
+thread_local uint8_t  Segment::_clipStopY = 1;
 #endif
 
 // copy constructor
@@ -856,7 +856,7 @@ void IRAM_ATTR_YN Segment::setPixelColor(int i, uint32_t col) const
           uint16_t lineCoords[2][maxLineLength];    // uint16_t to save ram
           int lineLength[2] = {0};
   
-          static int prevRays[2] = {INT_MAX, INT_MAX}; // previous two ray numbers
+          static thread_local int prevRays[2] = {INT_MAX, INT_MAX}; // previous two ray numbers
           int closestEdgeIdx = INT_MAX; // index of the closest edge pixel
   
           for (int lineNr = 0; lineNr < 2; lineNr++) {
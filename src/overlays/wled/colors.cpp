@@ -465,8 +465,8 @@ static inline float maxf(float v, float w)
 uint32_t colorBalanceFromKelvin(uint16_t kelvin, uint32_t rgb)
 {
   //remember so that slow colorKtoRGB() doesn't have to run for every setPixelColor()
-  static byte correctionRGB[4] = {0,0,0,0};
-  static uint16_t lastKelvin = 0;
+  static thread_local byte correctionRGB[4] = {0,0,0,0};
+  static thread_local uint16_t lastKelvin = 0;
   if (lastKelvin != kelvin) colorKtoRGB(kelvin, correctionRGB);  // convert Kelvin to RGB
   lastKelvin = kelvin;
   byte rgbw[4];
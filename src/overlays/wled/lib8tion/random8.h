@@ -37,7 +37,7 @@
 #endif
 
 /// Seed for the random number generator functions
-extern uint16_t rand16seed; // = RAND16_SEED;
+extern thread_local uint16_t rand16seed; // = RAND16_SEED;
 
 /// Generate an 8-bit random number
 /// @returns random 8-bit number, in the range 0-255
@@ -426,19 +426,20 @@ typedef enum UM_SoundSimulations {
 
 um_data_t* simulateSound(uint8_t simulationId)
 {
-  static uint8_t samplePeak;
-  static float   FFT_MajorPeak;
-  static uint8_t maxVol;
-  static uint8_t binNum;
+  static thread_local uint8_t samplePeak;
+  static thread_local float   FFT_MajorPeak;
+  static thread_local uint8_t maxVol;
+  static thread_local uint8_t binNum;
 
-  static float    volumeSmth;
-  static uint16_t volumeRaw;
-  static float    my_magnitude;
+  static thread_local float    volumeSmth;
+  static thread_local uint16_t volumeRaw;
+  static thread_local float    my_magnitude;
 
   //arrays
   uint8_t *fftResult;
 
-  static um_data_t* um_data = nullptr;
+  // effects on different models can run on different threads at once
+  static thread_local um_data_t* um_data = nullptr;
 
   if (!um_data) {
     //claim storage for arrays
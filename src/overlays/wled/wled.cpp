@@ -20,6 +20,7 @@
 
 #include <cmath>
 #include <math.h>
+#include <mutex>
 #include <time.h>
 
 #include <SDL2/SDL.h>
@@ -33,7 +34,9 @@
 
 uint8_t blendingStyle = 0; // effect blending/transitionig style
 
-uint16_t rand16seed = 0;
+// every thread effects run on starts somewhere else in the sequence so the
+// same effect on two models doesn't produce the same "random" pattern
+thread_local uint16_t rand16seed = (uint16_t)random();
 time_t localTime = time(nullptr);
 uint8_t randomPaletteChangeTime = 0;
 bool stateChanged = false;
@@ -220,7 +223,8 @@ public:
     }
 
     bool getAudioSamples(std::array<float, NUM_SAMPLES>& samples, int& sampleRate) {
-        if (sourceType == -1) {
+        // effects on several models can get here at the same time
+        std::call_once(sourceInit, [this]() {
             std::string source = getSetting("WLEDAudioInput", "-- Playing Media --");
             if (source == "-- Playing Media --") {
                 sourceType = 0;
@@ -228,7 +232,7 @@ public:
                 sourceType = 1;
                 openAudioDevice(source);
             }
-        }
+        });
         bool retValue = false;
         if (sourceType == 0) {
             // Playing Media
@@ -259,6 +263,7 @@ public:
         return retValue;
     }
 
+    std::once_flag sourceInit;
     int sourceType = -1;
     int audioDev = 0;
     std::array<float, NUM_SAMPLES> inputSamples;
@@ -362,6 +367,9 @@ WS2812FXExt::WS2812FXExt(PixelOverlayModel* m, int map, int b,
 }
 
 WS2812FXExt::~WS2812FXExt() {
+    if (fftCfg) {
+        kiss_fftr_free(fftCfg);
+    }
     um_data.u_type = nullptr;
     um_data.u_data = nullptr;
 }
@@ -479,13 +487,16 @@ CRGB getCRGBForBand(int x, uint8_t* fftResult, int pal) {
 }
 void WS2812FXExt::processSamples(std::array<float, NUM_SAMPLES>& samples, int sampleRate) {
     kiss_fft_cpx fft_out[NUM_SAMPLES];
-    static kiss_fftr_cfg cfg = kiss_fftr_alloc(NUM_SAMPLES, false, 0, 0);
+    // kiss_fftr uses scratch space in the cfg so each strip needs its own
+    if (!fftCfg) {
+        fftCfg = kiss_fftr_alloc(NUM_SAMPLES, false, 0, 0);
+    }
 
     // GenerateSinWave(samples, sampleRate);
     // HammingWindow(samples);
 
     // compute fast fourier transform
-    kiss_fftr(cfg, (kiss_fft_scalar*)&samples[0], fft_out);
+    kiss_fftr(fftCfg, (kiss_fft_scalar*)&samples[0], fft_out);
 
     // arrays
 
@@ -100,7 +100,7 @@ constexpr float HALF_PI = 3.14159f / 2.0f;
 
 #define yield()
 
-extern uint16_t rand16seed;
+extern thread_local uint16_t rand16seed;
 extern time_t localTime;
 extern uint8_t randomPaletteChangeTime;
 extern bool stateChanged;
@@ -237,6 +237,7 @@ private:
 
     // Sound Reactive Stuff
     void processSamples(std::array<float, NUM_SAMPLES>& samples, int sampleRate);
+    struct kiss_fftr_state* fftCfg = nullptr;
     static constexpr int UDATA_ELEMENTS = 8;
     um_data_t um_data;
 
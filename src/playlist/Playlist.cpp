@@ -47,6 +47,9 @@
 #include "PlaylistEntryURL.h"
 #include "../util/RegExCache.h"
 
+// how long before the end of a sequence to start opening the next one
+#define PLAYLIST_PRELOAD_MS 3000
+
 static std::list<Playlist*> PL_CLEANUPS;
 Playlist* playlist = NULL;
 /*
@@ -800,6 +803,7 @@ int Playlist::Process(void) {
 
     if (!m_currentSection->at(m_sectionPosition)->IsPaused() && m_currentSection->at(m_sectionPosition)->IsPlaying()) {
         m_currentSection->at(m_sectionPosition)->Process();
+        PreloadNextSequence();
     }
 
     Playlist* pl = nullptr;
@@ -1029,6 +1033,10 @@ void Playlist::ProcessMedia(void) {
  *
  */
 void Playlist::SetIdle(bool exit) {
+    if (m_status != FPP_STATUS_IDLE) {
+        // stopped, don't hold on to the next sequence until something else is opened
+        sequence->ClearPreloadedSequence();
+    }
     m_status = FPP_STATUS_IDLE;
     m_currentState = "idle";
 
@@ -1514,6 +1522,60 @@ void Playlist::GetFilenamesForPos(int pos, std::string& seq, std::string& med) {
     }
 }
 
+/*
+ * When the current sequence is about to end, have the next entry's
+ * sequence opened and buffered so it can start without a gap.  Only
+ * the plain move to the next entry is handled, branches, inserted
+ * playlists, etc... just open their sequence when they start.
+ */
+void Playlist::PreloadNextSequence(void) {
+    if ((m_status != FPP_STATUS_PLAYLIST_PLAYING) || (m_insertedPlaylist != "") ||
+        ((m_stopAtPos != -1) && (m_stopAtPos <= (GetPosition() - 1)))) {
+        return;
+    }
+
+    PlaylistEntryBase* current = m_currentSection->at(m_sectionPosition);
+    if (current->GetNextBranchType() != PlaylistEntryBase::PlaylistBranchType::NoBranch) {
+        return;
+    }
+    std::string seq;
+    std::string med;
+    GetFilenames(current, seq, med);
+    uint64_t length = current->GetLengthInMS();
+    uint64_t elapsed = current->GetElapsedMS();
+    if (seq.empty() || (elapsed >= length) || ((length - elapsed) > PLAYLIST_PRELOAD_MS)) {
+        return;
+    }
+
+    PlaylistEntryBase* next = nullptr;
+    if ((m_sectionPosition + 1) < m_currentSection->size()) {
+        next = m_currentSection->at(m_sectionPosition + 1);
+    } else if (m_currentSectionStr == "LeadIn") {
+        if (m_mainPlaylist.size()) {
+            next = m_mainPlaylist[0];
+        } else if (m_leadOut.size()) {
+            next = m_leadOut[0];
+        }
+    } else if (m_currentSectionStr == "MainPlaylist") {
+        if (m_repeat && (!m_loopCount || ((m_loop + 1) < m_loopCount))) {
+            if (m_random != 2) {
+                next = m_mainPlaylist[0];
+            }
+        } else if (m_leadOut.size()) {
+            next = m_leadOut[0];
+        }
+    }
+    if (next == nullptr) {
+        return;
+    }
+
+    seq = "";
+    GetFilenames(next, seq, med);
+    if (!seq.empty()) {
+        sequence->PreloadSequenceFile(seq);
+    }
+}
+
 int Playlist::FindPosForMS(uint64_t& t, bool itemDefinedOnly) {
     if (itemDefinedOnly) {
         PlaylistEntryBase* bestOption = nullptr;
@@ -109,6 +109,7 @@ private:
     void SwitchToLeadOut(void);
 
     bool WillStopAfterCurrent();
+    void PreloadNextSequence(void);
     Playlist* SwitchToInsertedPlaylist(bool isStopping = false);
 
     volatile PlaylistStatus m_status;
@@ -84,6 +84,9 @@ std::string getFPPMediaDir(const std::string& path) {
     }
     return FPP_MEDIA_DIR + path;
 }
+void setFPPMediaDir(const std::string& path) {
+    FPP_MEDIA_DIR = path;
+}
 
 class SettingListener {
 public:
@@ -17,6 +17,8 @@
 
 std::string getFPPDDir(const std::string& path = "");
 std::string getFPPMediaDir(const std::string& path = "");
+// Use a media directory other than the configured one (tests, benchmarks)
+void setFPPMediaDir(const std::string& path);
 
 #define FPP_DIR getFPPDDir()
 #define FPP_DIR_MEDIA(a) getFPPMediaDir(a)
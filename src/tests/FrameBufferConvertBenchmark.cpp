@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "framebuffer/FrameBufferConvert.h"
+
+// Times filling a 1920x1080 frame buffer from RGB data with the old byte
+// at a time loop from FBCopyData (and the RGB565 lookup table from
+// IOCTLFrameBuffer) against the row converters, and checks both produce
+// the same frame.  Usage: FrameBufferConvertBenchmark [frames]
+
+#define FB_WIDTH 1920
+#define FB_HEIGHT 1080
+
+static uint16_t rgb565map[32][64][32];
+
+// FrameBuffer::FBCopyData before the row converters
+static void OldCopy(uint8_t* ob, int rowStride, int bpp, const uint8_t* buffer,
+                    int pixelsWide, int pixelsHigh, int pixelSize) {
+    const uint8_t* sR = buffer + 0;
+    const uint8_t* sG = buffer + 1;
+    const uint8_t* sB = buffer + 2;
+    for (int y = 0; y < pixelsHigh; y++) {
+        uint8_t* row = ob + (y * pixelSize * rowStride);
+        if (bpp == 16) {
+            uint8_t* d = row;
+            for (int x = 0; x < pixelsWide; x++) {
+                for (int sc = 0; sc < pixelSize; sc++) {
+                    *((uint16_t*)d) = rgb565map[*sR >> 3][*sG >> 2][*sB >> 3];
+                    d += 2;
+                }
+                sR += 3;
+                sG += 3;
+                sB += 3;
+            }
+        } else {
+            int add = bpp / 8;
+            uint8_t* dB = row;
+            uint8_t* dG = dB + 1;
+            uint8_t* dR = dB + 2;
+            for (int x = 0; x < pixelsWide; x++) {
+                for (int sc = 0; sc < pixelSize; sc++) {
+                    *dR = *sR;
+                    *dG = *sG;
+                    *dB = *sB;
+                    dR += add;
+                    dG += add;
+                    dB += add;
+                }
+                sR += 3;
+                sG += 3;
+                sB += 3;
+            }
+        }
+        for (int sc = 1; sc < pixelSize; sc++) {
+            memcpy(row + (sc * rowStride), row, rowStride);
+        }
+    }
+}
+
+static double BestOf(int runs, const std::function<void()>& fn) {
+    double best = 1e12;
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 50;
+
+    for (int r = 0; r < 32; r++) {
+        for (int g = 0; g < 64; g++) {
+            for (int b = 0; b < 32; b++) {
+                rgb565map[r][g][b] = (r << 11) | (g << 5) | b;
+            }
+        }
+    }
+
+    std::vector<uint8_t> src(FB_WIDTH * FB_HEIGHT * 3);
+    for (size_t x = 0; x < src.size(); x++) {
+        src[x] = (x * 37 + 11) & 0xFF;
+    }
+
+    int failed = 0;
+    printf("%dx%d, best of %d frames\n", FB_WIDTH, FB_HEIGHT, frames);
+    for (int bpp : { 32, 24, 16 }) {
+        int rowStride = FB_WIDTH * bpp / 8;
+        std::vector<uint8_t> oldOut(rowStride * FB_HEIGHT);
+        std::vector<uint8_t> newOut(rowStride * FB_HEIGHT);
+        FBRowConverter convert = GetFBRowConverter(bpp);
+
+        for (int pixelSize : { 1, 2, 4 }) {
+            int wide = FB_WIDTH / pixelSize;
+            int high = FB_HEIGHT / pixelSize;
+            double oldMS = BestOf(frames, [&]() {
+                OldCopy(&oldOut[0], rowStride, bpp, &src[0], wide, high, pixelSize);
+            });
+            double newMS = BestOf(frames, [&]() {
+                FBConvertRows(convert, &newOut[0], rowStride, &src[0], wide, high, pixelSize);
+            });
+            // the old loop never wrote the alpha byte, it was always 0
+            bool same = oldOut == newOut;
+            printf("%dbpp pixelSize %d:  old %6.2f ms   new %6.2f ms   %s\n",
+                   bpp, pixelSize, oldMS, newMS, same ? "same" : "DIFFERENT");
+            if (!same) {
+                failed++;
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "framebuffer/FrameBufferConvert.h"
+
+// Checks the row converters against a plain per pixel conversion for row
+// widths around the SIMD widths.  Both the source and destination rows end
+// right before an inaccessible page so reading or writing past the end of
+// a row crashes instead of passing.
+
+class GuardedBuffer {
+public:
+    GuardedBuffer(size_t len) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        mapLen = ((len + page - 1) / page + 1) * page;
+        base = (uint8_t*)mmap(nullptr, mapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        mprotect(base + mapLen - page, page, PROT_NONE);
+        data = base + mapLen - page - len;
+    }
+    ~GuardedBuffer() {
+        munmap(base, mapLen);
+    }
+
+    uint8_t* data;
+
+private:
+    uint8_t* base;
+    size_t mapLen;
+};
+
+static void ExpectedPixel(int bpp, const uint8_t* s, uint8_t* d) {
+    switch (bpp) {
+    case 16: {
+        uint16_t v = ((s[0] & 0xF8) << 8) | ((s[1] & 0xFC) << 3) | (s[2] >> 3);
+        memcpy(d, &v, 2);
+    } break;
+    case 24:
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+        break;
+    case 32:
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+        d[3] = 0;
+        break;
+    }
+}
+
+static bool CheckRow(int bpp, int pixels, int pixelSize) {
+    int bytesPP = bpp / 8;
+    GuardedBuffer src(pixels * 3);
+    GuardedBuffer dst(pixels * pixelSize * bytesPP);
+    for (int x = 0; x < pixels * 3; x++) {
+        src.data[x] = (x * 37 + 11) & 0xFF;
+    }
+    memset(dst.data, 0xAA, pixels * pixelSize * bytesPP);
+
+    GetFBRowConverter(bpp)(dst.data, src.data, pixels, pixelSize);
+
+    uint8_t expected[4];
+    for (int x = 0; x < pixels; x++) {
+        ExpectedPixel(bpp, src.data + x * 3, expected);
+        for (int sc = 0; sc < pixelSize; sc++) {
+            if (memcmp(dst.data + (x * pixelSize + sc) * bytesPP, expected, bytesPP)) {
+                printf("FAILED: %dbpp, %d pixels, pixelSize %d, pixel %d\n", bpp, pixels, pixelSize, x);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> widths;
+    for (int w = 1; w <= 65; w++) {
+        widths.push_back(w);
+    }
+    for (int w : { 127, 128, 129, 1919, 1920, 1921 }) {
+        widths.push_back(w);
+    }
+
+    int failed = 0;
+    int count = 0;
+    for (int bpp : { 16, 24, 32 }) {
+        for (int pixelSize : { 1, 2, 3 }) {
+            for (int w : widths) {
+                count++;
+                if (!CheckRow(bpp, w, pixelSize)) {
+                    failed++;
+                }
+            }
+        }
+    }
+    printf("FrameBufferConvert: %d of %d rows passed\n", count - failed, count);
+    return failed ? 1 : 0;
+}
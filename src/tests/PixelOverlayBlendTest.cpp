@@ -0,0 +1,154 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "overlays/PixelOverlayBlend.h"
+
+// Checks BlendOverlayData and BlendOverlayPixel for every overlay state
+// against the blend written out one channel at a time.  Lengths cover the
+// SIMD widths (16 bytes, 48 for the per pixel states) with partial pixels
+// at the end, and the data has plenty of zeros and 255s so the transparent
+// and saturating cases get hit.
+
+typedef PixelOverlayState::PixelState PixelState;
+
+static uint8_t Reference(PixelState st, uint8_t d, uint8_t s, uint8_t a) {
+    switch (st) {
+    case PixelState::Enabled:
+        return s;
+    case PixelState::Transparent:
+    case PixelState::TransparentRGB:
+        return a ? s : d;
+    case PixelState::Additive:
+        return std::min(d + s, 255);
+    case PixelState::Maximum:
+        return std::max(d, s);
+    case PixelState::AlphaBlend:
+        // s + d * (255 - a) / 255, rounded to nearest
+        return s + (d * (255 - a) * 2 + 255) / 510;
+    default:
+        return d;
+    }
+}
+
+static bool PerPixel(PixelState st) {
+    return st == PixelState::TransparentRGB || st == PixelState::AlphaBlend;
+}
+
+static void ReferenceBlend(PixelState st, uint8_t* dst, const uint8_t* src, int count) {
+    int x = 0;
+    if (PerPixel(st)) {
+        for (; x + 3 <= count; x += 3) {
+            uint8_t a = st == PixelState::AlphaBlend ? std::max(std::max(src[x], src[x + 1]), src[x + 2])
+                                                     : (src[x] | src[x + 1] | src[x + 2]);
+            for (int c = 0; c < 3; c++) {
+                dst[x + c] = Reference(st, dst[x + c], src[x + c], a);
+            }
+        }
+    }
+    // partial pixels are blended per channel, a channel is its own alpha
+    for (; x < count; x++) {
+        dst[x] = Reference(st, dst[x], src[x], src[x]);
+    }
+}
+
+static void Fill(std::mt19937& rng, std::vector<uint8_t>& v) {
+    for (auto& b : v) {
+        switch (rng() % 4) {
+        case 0:
+            b = 0;
+            break;
+        case 1:
+            b = 255;
+            break;
+        default:
+            b = rng();
+            break;
+        }
+    }
+}
+
+static bool CheckData(std::mt19937& rng, PixelState st, int count) {
+    std::vector<uint8_t> src(count), dst(count);
+    Fill(rng, src);
+    Fill(rng, dst);
+    std::vector<uint8_t> expected = dst;
+
+    ReferenceBlend(st, expected.data(), src.data(), count);
+    BlendOverlayData(st, dst.data(), src.data(), count);
+    for (int x = 0; x < count; x++) {
+        if (dst[x] != expected[x]) {
+            printf("FAILED: BlendOverlayData state %d, %d bytes, byte %d: %d != %d\n",
+                   (int)st, count, x, dst[x], expected[x]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool CheckPixel(std::mt19937& rng, PixelState st) {
+    std::vector<uint8_t> src(3), dst(3);
+    Fill(rng, src);
+    Fill(rng, dst);
+    std::vector<uint8_t> expected = dst;
+    ReferenceBlend(st, &expected[0], &src[0], 3);
+
+    // the middle channel isn't mapped and must be left alone
+    uint8_t unmapped = dst[1];
+    expected[1] = unmapped;
+    uint8_t* const d[3] = { &dst[0], nullptr, &dst[2] };
+    BlendOverlayPixel(st, d, &src[0]);
+    if (dst != expected) {
+        printf("FAILED: BlendOverlayPixel state %d: %d,%d,%d + %d,%d,%d\n",
+               (int)st, src[0], src[1], src[2], dst[0], dst[1], dst[2]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::mt19937 rng(1234);
+    std::vector<int> counts;
+    for (int c = 0; c <= 100; c++) {
+        counts.push_back(c);
+    }
+    for (int c : { 1023, 1024, 1025, 3 * 512 }) {
+        counts.push_back(c);
+    }
+
+    int failed = 0;
+    int count = 0;
+    for (PixelState st : { PixelState::Enabled, PixelState::Transparent, PixelState::TransparentRGB,
+                           PixelState::Additive, PixelState::Maximum, PixelState::AlphaBlend }) {
+        for (int c : counts) {
+            count++;
+            if (!CheckData(rng, st, c)) {
+                failed++;
+            }
+        }
+        for (int i = 0; i < 1000; i++) {
+            count++;
+            if (!CheckPixel(rng, st)) {
+                failed++;
+            }
+        }
+    }
+    printf("PixelOverlayBlend: %d of %d cases passed\n", count - failed, count);
+    return failed ? 1 : 0;
+}
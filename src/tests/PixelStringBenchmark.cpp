@@ -0,0 +1,125 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "channeloutput/PixelString.h"
+
+// Prepares the output for 48 strings of 1000 pixels, the way a pixel
+// controller cape does every frame, with the old per channel map loop and
+// with PixelString::prepareOutput's runs, and checks both give the same
+// output.  Usage: PixelStringBenchmark [frames]
+
+#define STRING_COUNT 48
+#define STRING_PIXELS 1000
+
+// PixelString::prepareOutput before the output runs
+static void OldPrepare(PixelString* ps, const uint8_t* channelData) {
+    int idx = 0;
+    for (auto& vs : ps->m_virtualStrings) {
+        int* map = vs.chMap;
+        uint8_t* brightness = vs.brightnessMap;
+        for (int ch = 0; ch < vs.chMapCount; ch++) {
+            ps->m_outputBuffer[idx++] = brightness[channelData[map[ch]]];
+        }
+    }
+}
+
+static double BestOf(int runs, const std::function<void()>& fn) {
+    double best = 1e12;
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static bool RunCase(int frames, const char* colorOrder, int brightness, const char* gamma) {
+    std::vector<PixelString*> strings;
+    for (int s = 0; s < STRING_COUNT; s++) {
+        Json::Value vs;
+        vs["description"] = "String " + std::to_string(s + 1);
+        vs["startChannel"] = s * STRING_PIXELS * 3;
+        vs["pixelCount"] = STRING_PIXELS;
+        vs["groupCount"] = 0;
+        vs["reverse"] = 0;
+        vs["colorOrder"] = colorOrder;
+        vs["nullNodes"] = 0;
+        vs["endNulls"] = 0;
+        vs["zigZag"] = 0;
+        vs["brightness"] = brightness;
+        vs["gamma"] = gamma;
+
+        Json::Value config;
+        config["portNumber"] = s;
+        config["virtualStrings"].append(vs);
+
+        PixelString* ps = new PixelString();
+        ps->Init(config);
+        strings.push_back(ps);
+    }
+
+    std::vector<uint8_t> channelData(FPPD_MAX_CHANNELS);
+    for (int x = 0; x < STRING_COUNT * STRING_PIXELS * 3; x++) {
+        channelData[x] = (x * 37 + 11) & 0xFF;
+    }
+    uint8_t* data = &channelData[0];
+
+    double oldUS = BestOf(frames, [&]() {
+        for (auto ps : strings) {
+            OldPrepare(ps, data);
+        }
+    });
+    std::vector<std::vector<uint8_t>> expected;
+    for (auto ps : strings) {
+        expected.emplace_back(ps->m_outputBuffer, ps->m_outputBuffer + ps->m_outputChannels);
+    }
+
+    double newUS = BestOf(frames, [&]() {
+        for (auto ps : strings) {
+            // nothing changes between frames here, make it redo everything
+            ps->outputBufferModified();
+            ps->prepareOutput(data);
+        }
+    });
+    bool same = true;
+    for (int s = 0; s < STRING_COUNT; s++) {
+        uint8_t* out = strings[s]->m_outputBuffer;
+        same &= std::equal(expected[s].begin(), expected[s].end(), out);
+        delete strings[s];
+    }
+
+    printf("%s, %3d%%, gamma %s:  old %7.1f us   new %7.1f us   %s\n",
+           colorOrder, brightness, gamma, oldUS, newUS, same ? "same" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    SetLogFile("stderr", false);
+    SetLogLevel("warn");
+
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    printf("%d strings x %d pixels, best of %d frames\n", STRING_COUNT, STRING_PIXELS, frames);
+
+    bool ok = RunCase(frames, "RGB", 100, "1.0");
+    ok &= RunCase(frames, "GRB", 70, "2.2");
+    ok &= RunCase(frames, "BGR", 100, "1.0");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <string>
+
+#include "Scheduler.h"
+#include "common.h"
+#include "log.h"
+#include "settings.h"
+
+// Loads a synthetic schedule of 5000 entries (playlists and repeating
+// commands, some at sunset, 14 days ahead) from a scratch media directory
+// and reports how long building, rebuilding and looking things up in the
+// scheduled item index takes.  Usage: SchedulerBenchmark [entries]
+//
+// Everything is scheduled from tomorrow on so nothing runs while timing.
+
+class SchedulerBenchmark {
+public:
+    SchedulerBenchmark(int e) :
+        entries(e) {}
+
+    int Run();
+
+private:
+    void WriteSchedule(int edit);
+    double BestOf(int runs, const std::function<void()>& fn);
+
+    int entries;
+    std::string mediaDir;
+};
+
+static std::string DateString(time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char buf[16];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+}
+
+void SchedulerBenchmark::WriteSchedule(int edit) {
+    std::mt19937 rng(1234);
+    std::string startDate = DateString(time(nullptr) + 24 * 60 * 60);
+    std::string endDate = DateString(time(nullptr) + 365 * 24 * 60 * 60);
+
+    Json::Value sch(Json::arrayValue);
+    for (int i = 0; i < entries; i++) {
+        Json::Value e;
+        e["enabled"] = 1;
+        e["day"] = (int)(rng() % 16);
+        e["startDate"] = startDate;
+        e["endDate"] = endDate;
+
+        int h = rng() % 24;
+        int m = rng() % 60;
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%02d:%02d:00", h, m);
+        e["startTime"] = (rng() % 10 == 0) ? "SunSet" : buf;
+        snprintf(buf, sizeof(buf), "%02d:%02d:00", (h + 1) % 24, m);
+        e["endTime"] = buf;
+
+        if (i % 5 == 0) {
+            e["playlist"] = "Benchmark";
+            e["repeat"] = (int)(rng() % 2);
+        } else {
+            e["playlist"] = "";
+            e["command"] = "Benchmark No-op";
+            e["args"] = Json::Value(Json::arrayValue);
+            e["args"].append(std::to_string(i));
+            e["repeat"] = (rng() % 10 == 0) ? 1800 : 0;
+        }
+        if (i == 0) {
+            e["startTimeOffset"] = edit;
+        }
+        sch.append(e);
+    }
+    SaveJsonToFile(sch, FPP_DIR_CONFIG("/schedule.json"));
+}
+
+double SchedulerBenchmark::BestOf(int runs, const std::function<void()>& fn) {
+    double best = 1e12;
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int SchedulerBenchmark::Run() {
+    char tmpl[] = "/tmp/fpp-schedbench-XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        printf("Could not create a scratch media directory\n");
+        return 1;
+    }
+    mediaDir = tmpl;
+    setFPPMediaDir(mediaDir);
+    std::filesystem::create_directories(FPP_DIR_CONFIG(""));
+    std::filesystem::create_directories(FPP_DIR_PLAYLIST(""));
+    PutFileContents(FPP_DIR_PLAYLIST("/Benchmark.json"), "{}");
+
+    setSetting("fppMode", "player");
+    setSetting("ScheduleDistance", "14");
+    setSetting("Latitude", "40.0");
+    setSetting("Longitude", "-90.0");
+
+    WriteSchedule(0);
+    Scheduler* s = nullptr;
+    double load = BestOf(1, [&]() { s = new Scheduler(); });
+
+    int times = 0;
+    int items = s->GetScheduledItemCount(&times);
+    printf("%d entries, %d scheduled items at %d times\n", entries, items, times);
+    printf("initial load:              %8.1f ms\n", load);
+    printf("reload, unchanged:         %8.1f ms\n", BestOf(8, [&]() { s->LoadScheduleFromFile(); }));
+
+    // writing the file isn't part of the rebuild
+    int edit = 0;
+    double write = BestOf(5, [&]() { WriteSchedule(++edit); });
+    double reload = BestOf(8, [&]() {
+        WriteSchedule(++edit);
+        s->LoadScheduleFromFile();
+    });
+    printf("reload, one entry edited:  %8.1f ms\n", reload - write);
+
+    const int lookups = 20000;
+    s->CheckScheduledItems();
+    double next = BestOf(5, [&]() {
+        for (int i = 0; i < lookups; i++) {
+            s->GetNextScheduledPlaylist();
+        }
+    });
+    printf("GetNextScheduledPlaylist:  %8.3f us\n", next * 1000 / lookups);
+    double check = BestOf(5, [&]() {
+        for (int i = 0; i < lookups; i++) {
+            s->CheckScheduledItems();
+        }
+    });
+    printf("CheckScheduledItems:       %8.3f us\n", check * 1000 / lookups);
+
+    delete s;
+    std::filesystem::remove_all(mediaDir);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    SetLogFile("stderr", false);
+    SetLogLevel("warn");
+
+    int entries = argc > 1 ? atoi(argv[1]) : 5000;
+    SchedulerBenchmark bench(entries);
+    return bench.Run();
+}
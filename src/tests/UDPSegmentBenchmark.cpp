@@ -0,0 +1,252 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the GPL v2 as described in the
+ * included LICENSE.GPL file.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifndef PLATFORM_OSX
+#include <netinet/udp.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Sends frames of equally sized UDP packets, each a small header iovec
+// plus a data iovec the way UDPOutput builds DDP/E1.31 messages, first
+// with sendmmsg and then as UDP_SEGMENT (GSO) sends of up to 64 segments,
+// and reports packets per second for each.  By default the packets go to
+// a receiver on loopback which checks every one arrives intact and in
+// order.  Given an address the packets are sent there instead (nothing is
+// checked) so the NIC's segmentation/checksum offload is exercised too.
+// If the GSO send fails UDPOutput would fall back to sendmmsg for that
+// destination, that is reported instead of a rate.
+//
+// Usage: UDPSegmentBenchmark [packetSize] [ip port]
+
+#define PACKETS_PER_FRAME 1000
+#define FRAMES 200
+#define HEADER_SIZE 10
+#define MAX_GSO_SEGMENTS 64
+#define MAX_GSO_BYTES 65000
+
+class Sender {
+public:
+    Sender(int size, const sockaddr_in& d) :
+        packetSize(size), dest(d) {
+        headers.resize(PACKETS_PER_FRAME * HEADER_SIZE);
+        data.resize(packetSize - HEADER_SIZE);
+        for (size_t x = 0; x < data.size(); x++) {
+            data[x] = x * 37 + 11;
+        }
+        iovecs.resize(PACKETS_PER_FRAME * 2);
+        msgs.resize(PACKETS_PER_FRAME);
+        for (int p = 0; p < PACKETS_PER_FRAME; p++) {
+            iovecs[p * 2].iov_base = &headers[p * HEADER_SIZE];
+            iovecs[p * 2].iov_len = HEADER_SIZE;
+            iovecs[p * 2 + 1].iov_base = &data[0];
+            iovecs[p * 2 + 1].iov_len = data.size();
+            memset(&msgs[p], 0, sizeof(msgs[p]));
+            msgs[p].msg_hdr.msg_name = &dest;
+            msgs[p].msg_hdr.msg_namelen = sizeof(dest);
+            msgs[p].msg_hdr.msg_iov = &iovecs[p * 2];
+            msgs[p].msg_hdr.msg_iovlen = 2;
+        }
+    }
+
+    void NumberPackets(uint32_t& seq) {
+        for (int p = 0; p < PACKETS_PER_FRAME; p++) {
+            uint32_t s = htonl(seq++);
+            memcpy(&headers[p * HEADER_SIZE], &s, 4);
+        }
+    }
+
+    // returns false if the socket won't take any more right now
+    bool SendMMsg(int sock, int& sent) {
+        int oc = sendmmsg(sock, &msgs[sent], PACKETS_PER_FRAME - sent, MSG_DONTWAIT);
+        if (oc <= 0) {
+            return false;
+        }
+        sent += oc;
+        return true;
+    }
+
+    // returns false if the socket won't take any more right now, err is
+    // set if segmentation doesn't work at all
+    bool SendSegmented(int sock, int& sent, int& err) {
+#ifdef UDP_SEGMENT
+        int count = std::min(PACKETS_PER_FRAME - sent, std::min(MAX_GSO_SEGMENTS, MAX_GSO_BYTES / packetSize));
+        struct msghdr hdr = msgs[sent].msg_hdr;
+        hdr.msg_iov = &iovecs[sent * 2];
+        hdr.msg_iovlen = count * 2;
+        char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof(control);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        *((uint16_t*)CMSG_DATA(cm)) = packetSize;
+        if (sendmsg(sock, &hdr, MSG_DONTWAIT) < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                err = errno;
+            }
+            return false;
+        }
+        sent += count;
+        return true;
+#else
+        err = ENOPROTOOPT;
+        return false;
+#endif
+    }
+
+    int packetSize;
+    sockaddr_in dest;
+    std::vector<uint8_t> headers;
+    std::vector<uint8_t> data;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct mmsghdr> msgs;
+};
+
+class Receiver {
+public:
+    Receiver(int packetSize) :
+        buffer(packetSize + 1) {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        int bufSize = 8 * 1024 * 1024;
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(sock, (sockaddr*)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(sock, (sockaddr*)&addr, &len);
+    }
+    ~Receiver() {
+        close(sock);
+    }
+
+    // reads everything waiting, checking the packets are whole and in order
+    void Drain(const std::vector<uint8_t>& expected) {
+        int len;
+        while ((len = recv(sock, &buffer[0], buffer.size(), MSG_DONTWAIT)) > 0) {
+            uint32_t seq;
+            memcpy(&seq, &buffer[0], 4);
+            seq = ntohl(seq);
+            if (seq < nextSeq) {
+                outOfOrder++;
+            } else {
+                dropped += seq - nextSeq;
+                nextSeq = seq + 1;
+            }
+            if (len != expected.size() + HEADER_SIZE || memcmp(&buffer[HEADER_SIZE], &expected[0], expected.size())) {
+                corrupt++;
+            }
+            received++;
+        }
+    }
+
+    int sock;
+    sockaddr_in addr;
+    std::vector<uint8_t> buffer;
+    uint32_t nextSeq = 0;
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t corrupt = 0;
+};
+
+static bool RunMode(int packetSize, bool segmented, const sockaddr_in* remote) {
+    Receiver* rcv = remote ? nullptr : new Receiver(packetSize);
+    Sender snd(packetSize, remote ? *remote : rcv->addr);
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int bufSize = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+
+    uint32_t seq = 0;
+    double sendTime = 0;
+    int err = 0;
+    for (int f = 0; f < FRAMES && !err; f++) {
+        snd.NumberPackets(seq);
+        int sent = 0;
+        while (sent < PACKETS_PER_FRAME && !err) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = segmented ? snd.SendSegmented(sock, sent, err) : snd.SendMMsg(sock, sent);
+            sendTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!ok && rcv) {
+                // give the receiver a chance to catch up
+                rcv->Drain(snd.data);
+            } else if (!ok) {
+                usleep(100);
+            }
+        }
+        if (rcv) {
+            rcv->Drain(snd.data);
+        }
+    }
+    close(sock);
+
+    const char* name = segmented ? "UDP_SEGMENT" : "sendmmsg   ";
+    bool good = true;
+    if (err) {
+        printf("%d byte packets, %s: failed with %d - %s, UDPOutput would use sendmmsg\n",
+               packetSize, name, err, strerror(err));
+    } else {
+        printf("%d byte packets, %s: %8.0f packets/s", packetSize, name, FRAMES * PACKETS_PER_FRAME / sendTime);
+        if (rcv) {
+            // loopback only drops if the receiver falls behind, damage is a failure
+            printf("   received %llu, dropped %llu, out of order %llu, corrupt %llu",
+                   (unsigned long long)rcv->received, (unsigned long long)rcv->dropped,
+                   (unsigned long long)rcv->outOfOrder, (unsigned long long)rcv->corrupt);
+            good = !rcv->outOfOrder && !rcv->corrupt;
+        }
+        printf("\n");
+    }
+    delete rcv;
+    return good;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes = { 1450, 638 };
+    if (argc > 1) {
+        sizes = { atoi(argv[1]) };
+    }
+    sockaddr_in remote;
+    sockaddr_in* dest = nullptr;
+    if (argc > 3) {
+        memset(&remote, 0, sizeof(remote));
+        remote.sin_family = AF_INET;
+        remote.sin_addr.s_addr = inet_addr(argv[2]);
+        remote.sin_port = htons(atoi(argv[3]));
+        dest = &remote;
+    }
+
+    printf("%d packets per frame, %d frames\n", PACKETS_PER_FRAME, FRAMES);
+    bool ok = true;
+    for (int size : sizes) {
+        if (size <= HEADER_SIZE || size > MAX_GSO_BYTES) {
+            printf("Invalid packet size %d\n", size);
+            return 1;
+        }
+        ok &= RunMode(size, false, dest);
+        ok &= RunMode(size, true, dest);
+    }
+    return ok ? 0 : 1;
+}
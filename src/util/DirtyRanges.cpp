@@ -0,0 +1,92 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include "DirtyRanges.h"
+
+DirtyRanges::DirtyRanges(uint32_t channels, uint32_t blockShift) :
+    m_blockShift(blockShift),
+    m_numBlocks(((channels - 1) >> blockShift) + 1),
+    m_blocks(new std::atomic<uint64_t>[m_numBlocks]),
+    m_allDirty(0),
+    m_generation(1) {
+    for (uint32_t x = 0; x < m_numBlocks; x++) {
+        m_blocks[x] = 0;
+    }
+}
+
+bool DirtyRanges::blockRange(uint32_t start, uint32_t count, uint32_t& first, uint32_t& last) const {
+    if (count == 0) {
+        return false;
+    }
+    first = start >> m_blockShift;
+    last = (start + count - 1) >> m_blockShift;
+    if (first >= m_numBlocks) {
+        return false;
+    }
+    if (last >= m_numBlocks) {
+        last = m_numBlocks - 1;
+    }
+    return true;
+}
+
+// Block stamps are the generation shifted up one with the low bit set if
+// the write was a restore.  A restore does not need to redo blocks whose
+// last write was the previous restore to the same state.
+void DirtyRanges::markDirty(uint32_t start, uint32_t count) {
+    uint32_t first, last;
+    if (blockRange(start, count, first, last)) {
+        uint64_t stamp = getGeneration() << 1;
+        for (uint32_t b = first; b <= last; b++) {
+            m_blocks[b].store(stamp, std::memory_order_relaxed);
+        }
+    }
+}
+
+void DirtyRanges::markAllDirty() {
+    m_allDirty.store(getGeneration(), std::memory_order_relaxed);
+}
+
+void DirtyRanges::markRestored(uint32_t start, uint32_t count, uint64_t generation) {
+    if (m_allDirty.load(std::memory_order_relaxed) >= generation) {
+        markDirty(start, count);
+        return;
+    }
+    uint32_t first, last;
+    if (blockRange(start, count, first, last)) {
+        uint64_t stamp = (getGeneration() << 1) | 1;
+        uint64_t since = generation << 1;
+        for (uint32_t b = first; b <= last; b++) {
+            uint64_t s = m_blocks[b].load(std::memory_order_relaxed);
+            if (s >= since && s != (since | 1)) {
+                m_blocks[b].store(stamp, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+bool DirtyRanges::isDirty(uint32_t start, uint32_t count, uint64_t sinceGeneration) const {
+    if (m_allDirty.load(std::memory_order_relaxed) >= sinceGeneration) {
+        return true;
+    }
+    uint32_t first, last;
+    if (blockRange(start, count, first, last)) {
+        uint64_t since = sinceGeneration << 1;
+        for (uint32_t b = first; b <= last; b++) {
+            if (m_blocks[b].load(std::memory_order_relaxed) >= since) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
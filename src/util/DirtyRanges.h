@@ -0,0 +1,49 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Tracks which parts of a channel buffer have been written recently so
+// outputs can skip ranges that have not changed.  The buffer is split into
+// blocks and each block records the generation it was last written in.
+// The generation is bumped once per frame, a reader remembers the
+// generation it last looked at and asks if anything in its range has been
+// written since.  Marking is lock free and may be called from any thread.
+class DirtyRanges {
+public:
+    DirtyRanges(uint32_t channels, uint32_t blockShift = 8);
+
+    void markDirty(uint32_t start, uint32_t count);
+    void markAllDirty();
+
+    // The range is being put back to the state it was in at the given
+    // generation (blanked again, same frame re-read, etc...) so only the
+    // blocks written since then actually change.
+    void markRestored(uint32_t start, uint32_t count, uint64_t generation);
+
+    bool isDirty(uint32_t start, uint32_t count, uint64_t sinceGeneration) const;
+
+    uint64_t getGeneration() const { return m_generation.load(std::memory_order_acquire); }
+    void nextGeneration() { m_generation.fetch_add(1, std::memory_order_acq_rel); }
+
+private:
+    bool blockRange(uint32_t start, uint32_t count, uint32_t& first, uint32_t& last) const;
+
+    uint32_t m_blockShift;
+    uint32_t m_numBlocks;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_blocks;
+    std::atomic<uint64_t> m_allDirty;
+    std::atomic<uint64_t> m_generation;
+};
@@ -0,0 +1,69 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single producer/single consumer ring buffer.
+// push() must only be called from one thread and pop() from one
+// other thread (or while holding a lock that serializes all the
+// consumers).  No locks and no allocations after construction.
+template<class T>
+class SPSCRing {
+public:
+    explicit SPSCRing(size_t capacity) :
+        m_slots(capacity + 1) {}
+
+    bool push(const T& v) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t next = increment(head);
+        if (next == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_slots[head] = v;
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& v) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        v = m_slots[tail];
+        m_tail.store(increment(tail), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+    bool full() const {
+        return increment(m_head.load(std::memory_order_acquire)) == m_tail.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : head + m_slots.size() - tail;
+    }
+    size_t capacity() const { return m_slots.size() - 1; }
+
+private:
+    size_t increment(size_t i) const {
+        return (i + 1) == m_slots.size() ? 0 : i + 1;
+    }
+
+    std::vector<T> m_slots;
+    alignas(64) std::atomic<size_t> m_head = 0;
+    alignas(64) std::atomic<size_t> m_tail = 0;
+};
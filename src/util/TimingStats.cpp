@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include "TimingStats.h"
+
+TimingStats::TimingStats(uint32_t numSamples, uint32_t deadlineUS) :
+    m_numSamples(numSamples),
+    m_samples(new std::atomic<uint32_t>[numSamples]),
+    m_count(0),
+    m_max(0),
+    m_deadline(deadlineUS),
+    m_missed(0) {
+    for (uint32_t x = 0; x < m_numSamples; x++) {
+        m_samples[x] = 0;
+    }
+}
+
+void TimingStats::addSample(uint32_t us) {
+    uint64_t idx = m_count.fetch_add(1, std::memory_order_relaxed);
+    m_samples[idx % m_numSamples].store(us, std::memory_order_relaxed);
+
+    uint32_t curMax = m_max.load(std::memory_order_relaxed);
+    while (us > curMax && !m_max.compare_exchange_weak(curMax, us, std::memory_order_relaxed)) {
+    }
+    uint32_t deadline = m_deadline.load(std::memory_order_relaxed);
+    if (deadline && us > deadline) {
+        m_missed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TimingStats::reset() {
+    m_count = 0;
+    m_max = 0;
+    m_missed = 0;
+}
+
+void TimingStats::toJson(Json::Value& result) const {
+    uint64_t count = m_count;
+    uint32_t num = count < m_numSamples ? count : m_numSamples;
+
+    std::vector<uint32_t> samples(num);
+    for (uint32_t x = 0; x < num; x++) {
+        samples[x] = m_samples[x].load(std::memory_order_relaxed);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    result["count"] = (Json::UInt64)count;
+    result["p50"] = num ? samples[num * 50 / 100] : 0;
+    result["p95"] = num ? samples[num * 95 / 100] : 0;
+    result["p99"] = num ? samples[num * 99 / 100] : 0;
+    result["max"] = m_max.load();
+    if (m_deadline) {
+        result["missed"] = (Json::UInt64)m_missed.load();
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Json {
+class Value;
+}
+
+// Keeps the most recent timing samples (in microseconds) so percentiles
+// can be reported without logging every frame.  addSample is lock free
+// and does not allocate so it can be used from the output threads.
+class TimingStats {
+public:
+    TimingStats(uint32_t numSamples = 1024, uint32_t deadlineUS = 0);
+
+    void addSample(uint32_t us);
+    void setDeadline(uint32_t us) { m_deadline = us; }
+    void reset();
+
+    uint64_t getCount() const { return m_count; }
+
+    // fills in count, p50, p95, p99, max (and missed if a deadline is set)
+    void toJson(Json::Value& result) const;
+
+private:
+    uint32_t m_numSamples;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_samples;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint32_t> m_max;
+    std::atomic<uint32_t> m_deadline;
+    std::atomic<uint64_t> m_missed;
+};